@@ -320,6 +320,25 @@ apop_data * apop_predict(apop_data *d, apop_model *m);
 
 apop_model *apop_beta_from_mean_var(double m, double v); //in apop_beta.c
 
+//apop_dual.c
+/** A dual number: a value and its derivative with respect to one input. See \ref dualsec. */
+typedef struct {
+    double val, dx;
+} apop_dual;
+apop_dual apop_dual_const(double x);
+apop_dual apop_dual_add(apop_dual a, apop_dual b);
+apop_dual apop_dual_sub(apop_dual a, apop_dual b);
+apop_dual apop_dual_mul(apop_dual a, apop_dual b);
+apop_dual apop_dual_div(apop_dual a, apop_dual b);
+apop_dual apop_dual_scale(apop_dual a, double s);
+apop_dual apop_dual_exp(apop_dual a);
+apop_dual apop_dual_log(apop_dual a);
+apop_dual apop_dual_sqrt(apop_dual a);
+apop_dual apop_dual_lgamma(apop_dual a);
+apop_dual apop_dual_pow(apop_dual a, apop_dual b);
+apop_dual apop_dual_normal_cdf(apop_dual a);
+int apop_dual_score(apop_data *d, gsl_vector *out, apop_model *m);
+
 #define apop_model_set_parameters(in, ...) apop_model_set_parameters_base((in), (double []) {__VA_ARGS__})
 apop_model *apop_model_set_parameters_base(apop_model *in, double ap[]);
 
@@ -385,6 +404,7 @@ Apop_var_declare( double apop_vector_cov(gsl_vector const *v1, gsl_vector const
                                          gsl_vector const *weights))
 
 Apop_var_declare( double apop_vector_distance(const gsl_vector *ina, const gsl_vector *inb, const char metric, const double norm) )
+Apop_var_declare( apop_data * apop_data_distance_matrix(apop_data const *a, apop_data const *b, char metric, double bandwidth, apop_data const *covariance) )
 
 Apop_var_declare( void apop_vector_normalize(gsl_vector *in, gsl_vector **out, const char normalization_type) )
 
@@ -394,9 +414,48 @@ long double apop_vector_entropy(gsl_vector *in);
 long double apop_matrix_sum(const gsl_matrix *m);
 double apop_matrix_mean(const gsl_matrix *data);
 void apop_matrix_mean_and_var(const gsl_matrix *data, double *mean, double *var);
-apop_data * apop_data_summarize(apop_data *data);
+Apop_var_declare( apop_data * apop_data_summarize(apop_data *indata, char all_pages) )
 Apop_var_declare( double * apop_vector_percentiles(gsl_vector *data, char rounding)  )
 
+//apop_accumulate.c
+/** A mergeable running summary of the columns of a data set; see \ref apop_accumulator_alloc. */
+typedef struct {
+    size_t columns;
+    double n;             /**< The number of rows seen. */
+    double wsum;          /**< The total weight of the rows seen. */
+    double *mean, *m2, *m3, *m4; /**< Per column: the mean, and the weighted sums of squared, cubed, and fourth-power deviations from it. */
+    double *min, *max;
+    gsl_matrix *comoment; /**< The weighted sums of products of deviations, for each pair of columns. */
+    apop_name *names;
+} apop_accumulator;
+apop_accumulator *apop_accumulator_alloc(size_t columns);
+void apop_accumulator_free(apop_accumulator *a);
+int apop_accumulator_add(apop_accumulator *a, apop_data const *chunk);
+int apop_accumulator_merge(apop_accumulator *into, apop_accumulator const *from);
+apop_data *apop_accumulator_summarize(apop_accumulator const *a);
+apop_data *apop_accumulator_covariance(apop_accumulator const *a);
+
+//apop_tdigest.c
+/** A mergeable sketch of a distribution, for approximate percentiles in bounded memory;
+see \ref apop_tdigest_alloc. */
+typedef struct {
+    double compression;   /**< The accuracy parameter; about the maximum number of centroids. */
+    double total_weight, min, max;
+    size_t centroid_ct, unmerged_ct, capacity;
+    double *means, *weights;  /**< The centroids, followed by not-yet-merged points. */
+} apop_tdigest;
+apop_tdigest *apop_tdigest_alloc(double compression);
+void apop_tdigest_free(apop_tdigest *t);
+void apop_tdigest_add(apop_tdigest *t, double x, double weight);
+void apop_tdigest_add_vector(apop_tdigest *t, gsl_vector const *v, gsl_vector const *weights);
+void apop_tdigest_add_data(apop_tdigest *t, apop_data const *d);
+int apop_tdigest_add_query(apop_tdigest *t, const char * fmt, ...) __attribute__ ((format (printf,2,3))); //in apop_db.c
+void apop_tdigest_merge(apop_tdigest *into, apop_tdigest const *from);
+double apop_tdigest_quantile(apop_tdigest *t, double q);
+double apop_tdigest_median(apop_tdigest *t);
+double *apop_tdigest_percentiles(apop_tdigest *t);
+double apop_tdigest_cdf(apop_tdigest *t, double x);
+
 apop_data *apop_test_fisher_exact(apop_data *intab); //in apop_fisher.c
 
 //from apop_t_f_chi.c:
@@ -418,6 +477,8 @@ Apop_var_declare( apop_data * apop_f_test (apop_model *est, apop_data *contrast)
 
 apop_data * apop_text_unique_elements(const apop_data *d, size_t col);
 gsl_vector * apop_vector_unique_elements(const gsl_vector *v);
+apop_data * apop_text_unique_counts(const apop_data *d, size_t col);
+apop_data * apop_vector_unique_counts(const gsl_vector *v);
 Apop_var_declare( apop_data * apop_data_to_factors(apop_data *data, char intype, int incol, int outcol) )
 Apop_var_declare( apop_data * apop_data_get_factor_names(apop_data *data, int col, char type) )
 
@@ -439,6 +500,7 @@ double apop_rng_GHgB3(gsl_rng * r, double* a); //in apop_asst.c
 gsl_rng *apop_rng_get_thread_base(int thread);
 
 int apop_arms_draw (double *out, gsl_rng *r, apop_model *m);
+int apop_arms_draw_batch (double *out, size_t n, gsl_rng *r, apop_model *m);
 
 
     // maximum likelihod estimation related functions
@@ -519,6 +581,10 @@ typedef void (*apop_score_type)(apop_data *d, gsl_vector *gradient, apop_model *
 #define apop_score_hash(m1) ((size_t)((m1)->log_likelihood ? (m1)->log_likelihood : (m1)->p))
 make_vtab_fns(apop_score)
 
+typedef apop_dual (*apop_dual_ll_type)(apop_data *d, apop_dual const *params, apop_model *m);
+#define apop_dual_ll_hash(m1) ((size_t)((m1)->log_likelihood ? (m1)->log_likelihood : (m1)->p))
+make_vtab_fns(apop_dual_ll)
+
 typedef apop_model* (*apop_parameter_model_type)(apop_data *, apop_model *);
 #define apop_parameter_model_hash(m1) ((size_t)((m1)->log_likelihood ? (m1)->log_likelihood : (m1)->p)*33 + (m1)->estimate ? (size_t)(m1)->estimate: 27)
 make_vtab_fns(apop_parameter_model)
@@ -552,6 +618,8 @@ int apop_system(const char *fmt, ...) __attribute__ ((format (printf,1,2)));
 
 //Histograms and PMFs
 gsl_vector * apop_vector_moving_average(gsl_vector *, size_t);
+Apop_var_declare( gsl_vector * apop_vector_rolling(gsl_vector const *v, size_t window, char stat, double q, char align, char edge) )
+Apop_var_declare( gsl_vector * apop_vector_rolling_cov(gsl_vector const *v1, gsl_vector const *v2, size_t window, char align, char edge) )
 apop_data * apop_histograms_test_goodness_of_fit(apop_model *h0, apop_model *h1);
 apop_data * apop_test_kolmogorov(apop_model *m1, apop_model *m2);
 apop_data *apop_data_pmf_compress(apop_data *in);
@@ -668,12 +736,14 @@ Apop_var_declare( apop_data * apop_rake(char const *margin_table, char * const*v
     //Some linear algebra utilities
 
 double apop_det_and_inv(const gsl_matrix *in, gsl_matrix **out, int calc_det, int calc_inv);
+int apop_matrix_inverse_into(const gsl_matrix *in, gsl_matrix *out, double *det);
 Apop_var_declare( apop_data * apop_dot(const apop_data *d1, const apop_data *d2, char form1, char form2) )
+Apop_var_declare( int apop_dot_into(const apop_data *d1, const apop_data *d2, apop_data *out, char form1, char form2, double alpha, double beta) )
 Apop_var_declare( int         apop_vector_bounded(const gsl_vector *in, long double max) )
 gsl_matrix * apop_matrix_inverse(const gsl_matrix *in) ;
 double      apop_matrix_determinant(const gsl_matrix *in) ;
 //apop_data*  apop_sv_decomposition(gsl_matrix *data, int dimensions_we_want);
-Apop_var_declare( apop_data *  apop_matrix_pca(gsl_matrix *data, int const dimensions_we_want) )
+Apop_var_declare( apop_data *  apop_matrix_pca(gsl_matrix *data, int const dimensions_we_want, char method, int power_iterations, gsl_rng *rng) )
 Apop_var_declare( gsl_vector * apop_vector_stack(gsl_vector *v1, gsl_vector const * v2, char inplace) )
 Apop_var_declare( gsl_matrix * apop_matrix_stack(gsl_matrix *m1, gsl_matrix const * m2, char posn, char inplace) )
 
@@ -1173,8 +1243,14 @@ typedef struct{
 
 <tr><td> "PR cg"  </td><td> Polak-Ribiere conjugate gradient  </td><td>  </td></tr>
 
+<tr><td> "L-BFGS"  </td><td> Limited-memory BFGS  </td><td> Keeps only the last \c lbfgs_memory steps, so it suits models with many parameters. Respects the box given by \c lower_bound and \c upper_bound, if any. Uses the model's score if it has one, else a numerical gradient. </td></tr>
+
+<tr><td> "SGD"  </td><td> Stochastic gradient descent (Adam)  </td><td> Each step uses the gradient on a random minibatch of \c batch_size rows, so it suits data sets too large to evaluate in full at every step. The model's log likelihood must be a sum over rows. Uses the model's score if it has one, else a numerical gradient. \c step_size is the learning rate; see also \c learning_decay, \c sgd_window, and \c sgd_patience. Respects \c lower_bound and \c upper_bound. </td></tr>
+
 <tr><td> "Annealing"  </td><td> \ref simanneal "simulated annealing"         </td><td> Slow but works for objectives of arbitrary complexity, including stochastic objectives.</td></tr>
 
+<tr><td> "Parallel tempering"  </td><td> \ref simanneal "parallel tempering"         </td><td> Several random walks at fixed temperatures between \c t_min and \c t_initial that trade states; the walks run in parallel if \c threaded is \c 'y'. For rugged surfaces with many local optima.</td></tr>
+
 <tr><td> "Newton"</td><td> Newton's method  </td><td> Search by finding a root of the derivative. Expects that gradient is reasonably well-behaved. </td></tr>
 
 <tr><td> "Newton hybrid"</td><td> Newton's method/gradient descent hybrid        </td><td>  Find a root of the derivative via the Hybrid method </td> If Newton proposes stepping outside of a certain interval, use an alternate method. See <a href="https://www.gnu.org/software/gsl/manual/gsl-ref_35.html#SEC494">the GSL manual</a> for discussion.</tr>
@@ -1199,6 +1275,75 @@ delta;
     int         n_tries, iters_fixed_T;
     double      k, t_initial, mu_t, t_min ;
     gsl_rng     *rng;
+    int         replicas; /**< For \c "Parallel tempering", the number of walks on the temperature ladder. They run in parallel only if \c threaded is \c 'y'. Default: 8. */
+    int         starts; /**< If greater than one, run this many searches from dispersed
+                             starting points and keep the one with the best log likelihood. The
+                             searches run in parallel if \c threaded is \c 'y', under the same rules. The
+                             output model's info page reports the number of starts, how many
+                             reached the best optimum (to within \c tolerance), the spread
+                             between the best and worst log likelihoods, and an
+                             <tt>"<Optima>"</tt> page listing each search's log likelihood,
+                             status, and parameters, best first. Default: one start. */
+    apop_model  *start_model; /**< For multiple starts, draw the starting points from this
+                             model, e.g. a prior. Its \c dsize must match the number of
+                             parameters. If \c NULL, starting points are a Latin hypercube
+                             sample from the box given by \c lower_bound and \c upper_bound. */
+    double      *lower_bound, /**< The lower corner of a box on the parameters, one element
+                             per parameter. The \c "L-BFGS" method keeps its search inside the
+                             box. For multiple starts without a \c start_model, starting points
+                             are drawn from the box; if there are no bounds, each dimension's box
+                             for that purpose is the starting point (default 1) plus or minus
+                             twice the larger of one and the starting point's magnitude. */
+                *upper_bound; /**< The upper corner of the box; see \c lower_bound. */
+    int         lbfgs_memory; /**< For the \c "L-BFGS" method, the number of past steps used to
+                             approximate the Hessian. Default: 10. */
+    int         batch_size; /**< For the \c "SGD" method, the number of rows drawn (with
+                             replacement) for each step. Default: 1000, or all rows if there are fewer. */
+    double      learning_decay; /**< For \c "SGD", the learning rate at step \f$t\f$ is
+                             <tt>step_size/(1 + learning_decay * t)</tt>. Default: 0, a constant rate. */
+    int         sgd_window, /**< For \c "SGD", the log likelihood per row is averaged over
+                             windows of this many steps. Default: 50. */
+                sgd_patience; /**< For \c "SGD", stop after this many consecutive windows in
+                             which the mean log likelihood per row rose by less than \c tolerance.
+                             Default: 3. As with other methods, \c max_iterations caps the number of steps. */
+    int         ll_cache; /**< If positive, keep the last this many log likelihood evaluations,
+                             keyed on the exact parameter vector, and reuse them when the search
+                             revisits a point (as line searches often do). Worth it when the log
+                             likelihood is expensive. Minibatch evaluations under \c "SGD" are
+                             never cached. The output model's info page reports the <tt>log
+                             likelihood cache hits</tt> and <tt>log likelihood cache lookups</tt>;
+                             if \c verbose, the hit rate is also printed at the end of the search.
+                             Default: 0, no cache. */
+    char        stochastic; /**< Set to \c 'y' if the log likelihood makes random draws, so
+                             two evaluations at the same point may differ. This turns off \c
+                             ll_cache. Default: \c 'n'. */
+    char        trace; /**< If \c 'y', add a <tt>"<Trace>"</tt> page to the output model's info
+                             page, with one row per iteration of the search. The columns are the iteration number,
+                             the log likelihood, the norm of the gradient, the step size (distance between
+                             this iteration's parameters and the last's), the counts of objective and
+                             gradient evaluations so far, seconds elapsed, and then the parameters.
+                             The objective count includes the evaluations made for numerical
+                             gradients. Items a method doesn't produce are \c NaN: the simplex method has no gradient,
+                             and the root-finding methods don't evaluate the log likelihood. For \c "SGD",
+                             the log likelihood and gradient are for the minibatch. Simulated annealing is
+                             not traced. If the search ends before its first iteration, the page has
+                             the column names and no rows. With or without a trace, the info page
+                             gives the total <tt>log likelihood evaluations</tt> and <tt>gradient
+                             evaluations</tt>, including those for the covariance. Default: \c 'n'. */
+    void        (*trace_fn)(apop_data *row, void *trace_param); /**< If not \c NULL, call this
+                             after every iteration with a one-row \ref apop_data set, with the same
+                             named columns as the <tt>"<Trace>"</tt> page, whether or not \c trace is
+                             set. The row is a view that is reused; copy it if you need to keep it. */
+    void        *trace_param; /**< Passed as the second argument to \c trace_fn. */
+    char        threaded; /**< If \c 'y', numerical gradients and Hessians evaluate the
+                             perturbed parameter sets in parallel, each thread working on its own
+                             copy of the model; if \c 'n', one at a time. The results are
+                             identical either way. Set this only if your log likelihood keeps no
+                             shared state and is costly enough to be worth a thread per
+                             parameter. Even if set, models that pass their parameters on to
+                             another model, like those produced by \ref apop_model_fix_params
+                             or the other transformations, get one thread, because the copies
+                             would share that model. Default: \c 'n'. */
     apop_data   **path;    /**< If not \c NULL, record each vector tried by the optimizer as one row of this \ref apop_data set.
                               Each row of the \c matrix element holds the vector tried; the corresponding element in the \c vector is the evaluated value at that vector (after out-of-constraints penalties have been subtracted).
                               A new \ref apop_data set is allocated at the pointer you send in. This data set has no names; add them as desired. For a sample use, see \ref maxipage.
@@ -1289,6 +1434,15 @@ typedef struct{
     int own_pmf, own_kernel; /**< For internal use only. */
 }apop_kernel_density_settings;
 
+/** Cached factorization of the covariance matrix for the \ref apop_multivariate_normal.
+The model adds and maintains this group itself; all elements should be considered private.*/
+typedef struct {
+    gsl_matrix *factored; /**< A copy of the covariance that \c factor factors; if the parameters no longer match this, the cache is stale. */
+    struct apop_mvn_factor *factor; /**< The lower-triangular Cholesky factor \f$L\f$ of \f$\Sigma=LL'\f$ and \f$\ln|\Sigma|\f$,
+                                      reference counted so that a log likelihood or draw in progress keeps its copy
+                                      when another thread refactors. \c NULL if \c factored isn't positive definite. */
+} apop_mvn_settings;
+
 struct apop_mcmc_settings;
 
 /** A proposal distribution for \ref apop_mcmc_settings and its accompanying functions and
@@ -1374,6 +1528,12 @@ typedef struct apop_mcmc_settings {
     void (*base_step_fn)(double const *, struct apop_mcmc_proposal_s*, struct apop_mcmc_settings *); /**< If an \ref apop_mcmc_proposal_s struct has \c NULL \c step_fn, use this. If you don't want a step function, set this to a do-nothing function. */
     int (*base_adapt_fn)(struct apop_mcmc_proposal_s *ps, struct apop_mcmc_settings *ms); /**< If a \ref apop_mcmc_proposal_s has \c NULL \c adapt_fn, use this.  If you don't want an adapt function, set this to a do-nothing function.*/
 
+    int thin; /**< Record only every <tt>thin</tt>th step of the chain (after burn-in). Default: 1, record every step. */
+    char const *output_name; /**< If not \c NULL, stream recorded draws to this file, or database table if <tt>output_type=='d'</tt>, in batches as the chain runs. See \ref apop_model_metropolis. */
+    FILE *output_pipe; /**< Stream recorded draws to this already-open \c FILE instead of a named file. */
+    char output_type; /**< \c 'f' = text file (default when \c output_name is given), \c 'p' = pipe (default when \c output_pipe is given), \c 'd' = database table, \c 'b' = binary file of raw <tt>double</tt>s, one draw after another. */
+    int batch_size; /**< When streaming, how many draws to buffer before each write. Default: 10,000. */
+    long int keep_draws; /**< How many of the most recent draws to keep in memory, in the output \ref apop_pmf. Default when streaming: \c batch_size; default otherwise: all recorded draws. */
 } apop_mcmc_settings;
 
 /** \cond doxy_ignore */
@@ -1569,8 +1729,10 @@ typedef struct {
    char do_metro;   /**< Set to \c 'y' if the metropolis step is required (i.e.,
                            if you're not sure if the function is log-concave).*/
    double xprev;    /**< For internal use; please ignore. Previous value from Markov chain. */
-   int neval;       /**< On exit, the number of function evaluations performed */
-   arms_state *state;
+   int neval;       /**< On exit, the number of function evaluations performed, summed over all threads. */
+   arms_state *state;  /**< For internal use; please ignore. The envelope as built at setup, which each thread copies. */
+   arms_state **thread_states; /**< For internal use; please ignore. Each thread's own envelope and Markov chain. */
+   int thread_ct;   /**< For internal use; please ignore. The number of threads with a slot in \c thread_states. */
    apop_model *model; /**< The model from which to draw. Mandatory. Must have either a \c log_likelihood or \c p method.*/
 } apop_arms_settings;
 
@@ -1641,6 +1803,7 @@ Apop_settings_declarations(apop_dconstrain)
 Apop_settings_declarations(apop_composition)
 Apop_settings_declarations(apop_parts_wanted)
 Apop_settings_declarations(apop_kernel_density)
+Apop_settings_declarations(apop_mvn)
 Apop_settings_declarations(apop_coordinate_transform)
 
 #ifdef	__cplusplus
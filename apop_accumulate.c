@@ -0,0 +1,249 @@
+/** \file
+  Mergeable running summaries of the columns of a data set. */
+/* Copyright (c) 2026 by Ben Klemens.  Licensed under the GPLv2; see COPYING.  */
+
+#include "apop_internal.h"
+
+#define Acc_block 512
+
+/** Allocate an empty \ref apop_accumulator, which will summarize a data set arriving in chunks.
+
+The accumulator holds the count, total weight, mean, second through fourth central
+moments, minimum, and maximum of each column, plus the co-moment matrix between
+columns. Feed it data with \ref apop_accumulator_add; combine two accumulators with
+\ref apop_accumulator_merge; read the results with \ref apop_accumulator_summarize and
+\ref apop_accumulator_covariance.
+
+\code
+apop_accumulator *total = apop_accumulator_alloc(3);
+for (int i=0; i< file_ct; i++){
+    apop_data *chunk = apop_text_to_data(files[i]);
+    apop_accumulator_add(total, chunk);
+    apop_data_free(chunk);
+}
+apop_data_show(apop_accumulator_summarize(total));
+\endcode
+
+\li Merging is exact, up to rounding: the summary of a set of merged accumulators is the
+summary of the full data set, however it was split. So each thread or worker can keep
+its own accumulator, and you can merge them at the end.
+
+\param columns The number of columns in the matrix of the data sets to come.
+\return An empty accumulator, or \c NULL on allocation failure.
+\see apop_accumulator_free
+*/
+apop_accumulator *apop_accumulator_alloc(size_t columns){
+    apop_accumulator *out = malloc(sizeof(apop_accumulator));
+    Apop_stopif(!out, return NULL, 0, "allocation error.");
+    *out = (apop_accumulator){.columns=columns,
+        .mean = calloc(columns, sizeof(double)),
+        .m2 = calloc(columns, sizeof(double)),
+        .m3 = calloc(columns, sizeof(double)),
+        .m4 = calloc(columns, sizeof(double)),
+        .min = malloc(columns * sizeof(double)),
+        .max = malloc(columns * sizeof(double)),
+        .comoment = columns ? gsl_matrix_calloc(columns, columns) : NULL
+    };
+    Apop_stopif(columns && (!out->mean || !out->m2 || !out->m3 || !out->m4 || !out->min
+                            || !out->max || !out->comoment),
+            apop_accumulator_free(out); return NULL, 0, "allocation error.");
+    for (size_t j=0; j< columns; j++){
+        out->min[j] = GSL_POSINF;
+        out->max[j] = GSL_NEGINF;
+    }
+    return out;
+}
+
+/** Free an \ref apop_accumulator and everything it holds. */
+void apop_accumulator_free(apop_accumulator *a){
+    if (!a) return;
+    free(a->mean); free(a->m2); free(a->m3); free(a->m4);
+    free(a->min); free(a->max);
+    gsl_matrix_free(a->comoment);
+    apop_name_free(a->names);
+    free(a);
+}
+
+/** Fold the statistics of one accumulator into another.
+
+The update is that of Pébay (2008), <em>Formulas for robust, one-pass parallel
+computation of covariances and arbitrary-order statistical moments</em>, with
+observation counts replaced by total weights.
+
+\param into The accumulator that will hold the combined summary.
+\param from The accumulator to add in. It is not modified.
+\return 0 on success; 1 if the two have a different number of columns (and \c into is unchanged).
+*/
+int apop_accumulator_merge(apop_accumulator *into, apop_accumulator const *from){
+    Apop_stopif(!into || !from, return 1, 0, "Got a NULL accumulator.");
+    Apop_stopif(into->columns != from->columns, return 1, 0, "Merging an accumulator with "
+            "%zu columns into one with %zu columns.", from->columns, into->columns);
+    if (!into->names && from->names) into->names = apop_name_copy(from->names);
+    into->n += from->n;
+    for (size_t j=0; j< from->columns; j++){
+        into->min[j] = GSL_MIN(into->min[j], from->min[j]);
+        into->max[j] = GSL_MAX(into->max[j], from->max[j]);
+    }
+    if (!from->wsum) return 0;
+    if (!into->wsum){
+        into->wsum = from->wsum;
+        size_t k = from->columns;
+        memcpy(into->mean, from->mean, k*sizeof(double));
+        memcpy(into->m2, from->m2, k*sizeof(double));
+        memcpy(into->m3, from->m3, k*sizeof(double));
+        memcpy(into->m4, from->m4, k*sizeof(double));
+        if (k) gsl_matrix_memcpy(into->comoment, from->comoment);
+        return 0;
+    }
+    long double wa = into->wsum, wb = from->wsum, w = wa + wb;
+    double *delta = malloc(sizeof(double)*from->columns);
+    for (size_t j=0; j< from->columns; j++){
+        long double d = from->mean[j] - into->mean[j];
+        long double ma2 = into->m2[j], mb2 = from->m2[j];
+        long double ma3 = into->m3[j], mb3 = from->m3[j];
+        delta[j] = d;
+        into->m4[j] += from->m4[j] + gsl_pow_4(d) * wa*wb*(wa*wa - wa*wb + wb*wb)/(w*w*w)
+                        + 6*d*d*(wa*wa*mb2 + wb*wb*ma2)/(w*w) + 4*d*(wa*mb3 - wb*ma3)/w;
+        into->m3[j] += mb3 + gsl_pow_3(d) * wa*wb*(wa - wb)/(w*w) + 3*d*(wa*mb2 - wb*ma2)/w;
+        into->m2[j] += mb2 + d*d * wa*wb/w;
+        into->mean[j] += d * wb/w;
+    }
+    for (size_t i=0; i< from->columns; i++)
+        for (size_t j=0; j< from->columns; j++)
+            gsl_matrix_set(into->comoment, i, j, gsl_matrix_get(into->comoment, i, j)
+                                + gsl_matrix_get(from->comoment, i, j)
+                                + delta[i]*delta[j] * wa*wb/w);
+    into->wsum = w;
+    free(delta);
+    return 0;
+}
+
+/** Add a chunk of data to an \ref apop_accumulator.
+
+The chunk's own statistics are found with a two-pass method (means first, then
+centered moments, with the co-moments added via a BLAS rank-\f$k\f$ update), and then
+merged in via \ref apop_accumulator_merge.
+
+\param a     The accumulator.
+\param chunk An \ref apop_data set whose matrix has \c a->columns columns. If it has a
+\c weights vector, rows are weighted accordingly; weights must not be negative. If the
+accumulator has no column names yet, it takes them from the chunk.
+\return 0 on success; 1 on a size mismatch or negative weight, in which case \c a is unchanged.
+*/
+int apop_accumulator_add(apop_accumulator *a, apop_data const *chunk){
+    Apop_stopif(!a, return 1, 0, "Got a NULL accumulator.");
+    if (!chunk || !chunk->matrix || !chunk->matrix->size1) return 0;
+    gsl_matrix const *m = chunk->matrix;
+    gsl_vector const *w = chunk->weights;
+    size_t k = a->columns;
+    Apop_stopif(m->size2 != k, return 1, 0, "The accumulator has %zu columns, but this chunk has %zu.", k, m->size2);
+    Apop_stopif(w && w->size != m->size1, return 1, 0, "The chunk has %zu rows, but %zu weights.", m->size1, w->size);
+    if (w) Apop_stopif(gsl_vector_min(w) < 0, return 1, 0, "I can't use negative weights.");
+
+    apop_accumulator *c = apop_accumulator_alloc(k);
+    Apop_stopif(!c, return 1, 0, "allocation error.");
+    if (chunk->names && chunk->names->colct) c->names = apop_name_copy(chunk->names);
+    c->n = m->size1;
+    long double *sums = calloc(k, sizeof(long double)), wsum = 0;
+    for (size_t i=0; i< m->size1; i++){
+        double const *row = m->data + i*m->tda;
+        double wi = w ? gsl_vector_get(w, i) : 1;
+        for (size_t j=0; j< k; j++){
+            c->min[j] = GSL_MIN(c->min[j], row[j]);
+            c->max[j] = GSL_MAX(c->max[j], row[j]);
+            sums[j] += wi*row[j];
+        }
+        wsum += wi;
+    }
+    c->wsum = wsum;
+    if (wsum){
+        for (size_t j=0; j< k; j++) c->mean[j] = sums[j]/wsum;
+        gsl_matrix *block = gsl_matrix_alloc(GSL_MIN(Acc_block, m->size1), k);
+        for (size_t start=0; start< m->size1; start+=Acc_block){
+            size_t rows = GSL_MIN(Acc_block, m->size1 - start);
+            for (size_t i=0; i< rows; i++){
+                double const *row = m->data + (start+i)*m->tda;
+                double *brow = block->data + i*block->tda;
+                double wi = w ? gsl_vector_get(w, start+i) : 1, sw = sqrt(wi);
+                for (size_t j=0; j< k; j++){
+                    double d = row[j] - c->mean[j], d2 = d*d;
+                    c->m2[j] += wi*d2;
+                    c->m3[j] += wi*d2*d;
+                    c->m4[j] += wi*d2*d2;
+                    brow[j] = sw*d;
+                }
+            }
+            gsl_blas_dsyrk(CblasUpper, CblasTrans, 1, Apop_subm(block, 0, 0, rows, k), 1, c->comoment);
+        }
+        for (size_t i=0; i< k; i++)
+            for (size_t j=i+1; j< k; j++)
+                gsl_matrix_set(c->comoment, j, i, gsl_matrix_get(c->comoment, i, j));
+        gsl_matrix_free(block);
+    }
+    free(sums);
+    apop_accumulator_merge(a, c);
+    apop_accumulator_free(c);
+    return 0;
+}
+
+//As per apop_vector_var: if weights sum to less than 1.1, they're read as frequencies.
+static double effective_n(apop_accumulator const *a){ return a->wsum < 1.1 ? a->n : a->wsum; }
+
+/** Summarize an \ref apop_accumulator: the streaming counterpart to \ref apop_data_summarize.
+
+\return An \ref apop_data set with one row for each column of the accumulated data, and
+columns giving the mean, std dev, variance, skew, kurtosis, min, and max.
+\exception out->error='a'  Allocation error.
+
+\li The variance is the sample variance, with weights read as per \ref apop_vector_var;
+the skew and kurtosis are the population central moments, as per \ref
+apop_vector_skew_pop and \ref apop_vector_kurtosis_pop. Given the full data set and
+its weights, those functions would give the same numbers (up to rounding).
+\li The median needs the full data; see \ref apop_data_summarize.
+*/
+apop_data *apop_accumulator_summarize(apop_accumulator const *a){
+    Apop_stopif(!a, return NULL, 0, "Got a NULL accumulator.");
+    apop_data *out = apop_data_alloc(a->columns, 7);
+    Apop_stopif(out->error, return out, 0, "allocation error.");
+    char *colnames[] = {"mean", "std dev", "variance", "skew", "kurtosis", "min", "max"};
+    for (int i=0; i< 7; i++) apop_name_add(out->names, colnames[i], 'c');
+    if (a->names && a->names->colct) apop_name_stack(out->names, a->names, 'r', 'c');
+    else for (size_t j=0; j< a->columns; j++){
+        char *rowname;
+        Asprintf(&rowname, "col %zu", j);
+        apop_name_add(out->names, rowname, 'r');
+        free(rowname);
+    }
+    double len = effective_n(a);
+    for (size_t j=0; j< a->columns; j++){
+        double var = a->m2[j]/a->wsum * len/(len-1);
+        apop_data_set(out, j, 0, a->mean[j]);
+        apop_data_set(out, j, 1, sqrt(var));
+        apop_data_set(out, j, 2, var);
+        apop_data_set(out, j, 3, a->m3[j]/len);
+        apop_data_set(out, j, 4, a->m4[j]/len);
+        apop_data_set(out, j, 5, a->min[j]);
+        apop_data_set(out, j, 6, a->max[j]);
+    }
+    return out;
+}
+
+/** The sample variance/covariance matrix of the accumulated data, matching what \ref
+apop_data_covariance would give on the full data set.
+
+\return A square \ref apop_data set, with the accumulated column names on the rows and columns.
+\exception out->error='a'  Allocation error.
+*/
+apop_data *apop_accumulator_covariance(apop_accumulator const *a){
+    Apop_stopif(!a, return NULL, 0, "Got a NULL accumulator.");
+    apop_data *out = apop_data_alloc(a->columns, a->columns);
+    Apop_stopif(out->error, return out, 0, "allocation error.");
+    if (a->columns) {
+        gsl_matrix_memcpy(out->matrix, a->comoment);
+        double len = effective_n(a);
+        gsl_matrix_scale(out->matrix, len/(a->wsum*(len-1)));
+    }
+    apop_name_stack(out->names, a->names, 'c');
+    apop_name_stack(out->names, a->names, 'r', 'c');
+    return out;
+}
@@ -24,16 +24,36 @@ double perfunc(apop_arms_settings*, double x);
 void display(FILE *f, arms_state *env, apop_arms_settings *);
 int initial (apop_arms_settings* params, arms_state *state);
 
+/* The POINTs in an envelope link to each other, so a copy has to rebase the links. */
+static arms_state *arms_state_copy(arms_state const *in){
+    arms_state *out = malloc(sizeof(arms_state));
+    *out = *in;
+    out->p = malloc(in->npoint*sizeof(POINT));
+    memcpy(out->p, in->p, in->cpoint*sizeof(POINT));
+    for (int i=0; i< in->cpoint; i++){
+        if (in->p[i].pl) out->p[i].pl = out->p + (in->p[i].pl - in->p);
+        if (in->p[i].pr) out->p[i].pr = out->p + (in->p[i].pr - in->p);
+    }
+    return out;
+}
+
+static void arms_state_free(arms_state *in){
+    if (!in) return;
+    free(in->p);
+    free(in);
+}
+
 Apop_settings_copy(apop_arms,
-    out->state = malloc(sizeof(arms_state));
-    *out->state = *in->state;
+    out->state = arms_state_copy(in->state);
+    out->state->convex = &out->convex;
+    out->thread_states = calloc(out->thread_ct+1, sizeof(arms_state*));
 )
 
 Apop_settings_free(apop_arms,
-    if (in->state){
-        free(in->state->p);
-        free(in->state);
-	}
+    arms_state_free(in->state);
+    for (int i=0; i<= in->thread_ct; i++)
+        arms_state_free(in->thread_states[i]);
+    free(in->thread_states);
 )
 
 Apop_settings_init(apop_arms,
@@ -70,6 +90,8 @@ Apop_settings_init(apop_arms,
         assert(isfinite(out->state->metro_xprev));
         assert(isfinite(out->state->metro_yprev));
     }
+    out->thread_ct = omp_maxthreads;
+    out->thread_states = calloc(out->thread_ct+1, sizeof(arms_state*));
 )
 
 void distract_doxygen_arms(){/*Doxygen gets thrown by the settings macros. This decoy function is a workaround. */}
@@ -85,13 +107,16 @@ http://www.amsta.leeds.ac.uk/~wally.gilks/adaptive.rejection/web_page/Welcome.ht
 \li It is currently the default for the \ref apop_draw function given a univariate model, so you can just call that if you prefer.
 
 \li There are a great number of parameters, in the \c apop_arms_settings structure.  The structure also holds a history of the points tested to date. That means that the system will be more accurate as more draws are made. It also means that if the parameters change, or you use \ref apop_model_copy, you should call <tt>Apop_settings_rm_group(your_model, apop_arms)</tt> to clear the model of points that are not valid for a different situation.
+
+\li To make many draws at once, or to draw from several threads, see \ref apop_arms_draw_batch.
   */
 int apop_arms_draw (double *out, gsl_rng *r, apop_model *m){
-    apop_arms_settings *params = Apop_settings_get_group(m, apop_arms);
-    if (!params) params = Apop_model_add_group(m, apop_arms, .model=m);
+    return apop_arms_draw_batch(out, 1, r, m);
+}
+
+static int arms_draw_one(double *out, gsl_rng *r, apop_arms_settings *params, arms_state *state){
   POINT pwork;        /* a working point, not yet incorporated in envelope */
   int msamp=0;        /* the number of x-values currently sampled */
-  arms_state *state = params->state; 
   /* now do adaptive rejection */
   do {
     // Sample a new point from piecewise exponential envelope 
@@ -117,6 +142,44 @@ int apop_arms_draw (double *out, gsl_rng *r, apop_model *m){
   return 0;
 }
 
+/** Make \c n draws via adaptive rejection Metropolis sampling; see \ref apop_arms_draw for
+details, which makes one draw via this function.
+
+\param out An array of <tt>double</tt>s, of size at least \c n, to be filled with draws.
+\param n   The number of draws to make.
+\param r   A \c gsl_rng, probably allocated via \ref apop_rng_alloc.
+\param m   The univariate model from which to draw.
+\return Zero on success; nonzero if any draw failed.
+
+\li The envelope is built once, when the \ref apop_arms_settings group is attached to
+the model, and every draw in the batch refines the same envelope. Making many draws at
+once saves the per-draw lookup of the settings and state.
+
+\li Each thread has its own copy of the envelope and the Markov chain, made from the
+one built at setup on the thread's first draw, so threads drawing from the same model
+do not wait on each other. Attach the settings group (or make one draw) before starting
+threads, because attaching a group to a model is not thread-safe.
+*/
+int apop_arms_draw_batch (double *out, size_t n, gsl_rng *r, apop_model *m){
+    apop_arms_settings *params = Apop_settings_get_group(m, apop_arms);
+    if (!params) params = Apop_model_add_group(m, apop_arms, .model=m);
+    Apop_stopif(!params, return 1, 0, "Couldn't set up the ARMS envelope.");
+    int t = omp_threadnum, err = 0;
+    if (t < params->thread_ct){
+        if (!params->thread_states[t]) params->thread_states[t] = arms_state_copy(params->state);
+        for (size_t i=0; i< n && !err; i++)
+            err = arms_draw_one(out+i, r, params, params->thread_states[t]);
+    } else //more threads than we planned for; the extras share one state.
+        OMP_critical (arms_extra_threads)
+        {
+        t = params->thread_ct;
+        if (!params->thread_states[t]) params->thread_states[t] = arms_state_copy(params->state);
+        for (size_t i=0; i< n && !err; i++)
+            err = arms_draw_one(out+i, r, params, params->thread_states[t]);
+        }
+    return err;
+}
+
 int initial (apop_arms_settings* params,  arms_state *env){
 // to set up initial envelope
 
@@ -525,10 +588,12 @@ double logshift(double y, double y0){
 
 double perfunc(apop_arms_settings *params, double x){
 // to evaluate log density and increment count of evaluations 
-    Staticdef( apop_data *, d , apop_data_alloc(1,1));
+    static threadlocal apop_data *d = NULL;
+    if (!d) d = apop_data_alloc(1,1);
     d->matrix->data[0] = x;
   double y = apop_log_likelihood(d, params->model);
   Apop_assert(isfinite(y), "Evaluating the log likelihood of %g returned %g.", x, y);
+  OMP_atomic
   (params->neval)++; // increment count of function evaluations
   return y;
 }
@@ -5,13 +5,6 @@ Copyright (c) 2005--2007, 2010 by Ben Klemens.  Licensed under the GPLv2; see CO
 #include <gsl/gsl_math.h>
 #include <gsl/gsl_randist.h>
 #include <regex.h>
-#ifdef _OPENMP
-    #include <omp.h>
-    #define omp_threadnum omp_get_thread_num()
-#else
-    #define omp_threadnum 0
-
-#endif
 
 extern char *apop_nul_string;
 
@@ -357,21 +350,18 @@ gsl_rng *apop_rng_get_thread_base(int thread){
     static gsl_rng **rngs;
     static int rng_ct = -1;
 
-    if (thread==-1){
-        #ifdef OpenMP
-            thread = omp_get_thread_num();
-        #else
-            thread = 0;
-        #endif
-    }
+    if (thread==-1) thread = omp_threadnum;
 
+    //Allocate for the full team at once, so the list is rarely reallocated while
+    //other threads are reading it.
     OMP_critical(rng_get_thread)
     if (thread > rng_ct)
         {
-            rngs = realloc(rngs, sizeof(gsl_rng*)*(thread+1));
-            for (int i=rng_ct+1; i<= thread; i++)
+            int new_ct = GSL_MAX(thread, omp_maxthreads-1);
+            rngs = realloc(rngs, sizeof(gsl_rng*)*(new_ct+1));
+            for (int i=rng_ct+1; i<= new_ct; i++)
                 rngs[i] = apop_rng_alloc(++apop_opts.rng_seed);
-            rng_ct = thread;
+            rng_ct = new_ct;
         }
     return rngs[thread];
 }
@@ -338,6 +338,47 @@ apop_data * apop_query_to_data(const char * fmt, ...){
 }
 
 
+/** Stream the results of a query into an \ref apop_tdigest, without holding the full
+result set in memory.
+
+\param t   The digest.
+\param fmt A <tt>printf</tt>-style SQL query. The first column holds the data; if
+there is a second column, it holds the weights.
+\return 0 on success; 1 on query error.
+
+\li With SQLite, rows are added as the cursor steps through them. With mySQL, the
+result set is read in via \ref apop_query_to_data first.
+\li <tt>NULL</tt>s in the data column are ignored.
+\li The query can include printf-style format specifiers, such as <tt>apop_tdigest_add_query(t, "select age from %s", tablename)</tt>.
+*/
+int apop_tdigest_add_query(apop_tdigest *t, const char * fmt, ...){
+    Apop_stopif(!t, return 1, 0, "NULL digest.");
+    Fillin(query, fmt)
+    if (!apop_opts.db_engine) get_db_type();
+    if (apop_opts.db_engine == 'm'){
+        apop_data *d = apop_query_to_data("%s", query);
+        free(query);
+        Apop_stopif(d && d->error, apop_data_free(d); return 1, 0, "query error.");
+        if (d && d->matrix)
+            apop_tdigest_add_vector(t, Apop_cv(d, 0), d->matrix->size2 > 1 ? Apop_cv(d, 1) : NULL);
+        apop_data_free(d);
+        return 0;
+    }
+	if (db==NULL) apop_db_open(NULL);
+    sqlite3_stmt *stmt;
+    int status = sqlite3_prepare_v2(db, query, -1, &stmt, NULL);
+    Apop_stopif(status != SQLITE_OK, free(query); return 1, 0, "%s: %s", query, sqlite3_errmsg(db));
+    int weighted = sqlite3_column_count(stmt) > 1;
+    while ((status = sqlite3_step(stmt)) == SQLITE_ROW)
+        if (sqlite3_column_type(stmt, 0) != SQLITE_NULL)
+            apop_tdigest_add(t, sqlite3_column_double(stmt, 0),
+                                weighted ? sqlite3_column_double(stmt, 1) : 1);
+    sqlite3_finalize(stmt);
+    Apop_stopif(status != SQLITE_DONE, free(query); return 1, 0, "%s: %s", query, sqlite3_errmsg(db));
+    free(query);
+    return 0;
+}
+
     /** \cond doxy_ignore */
 //These used to do more, but I'll leave them as a macro anyway in case of future expansion.
 #define Store_settings  \
@@ -127,6 +127,28 @@ static void kurtFinalize(sqlite3_context *context){
       sqlite3_result_double(context, 0);
 }
 
+/** \cond doxy_ignore */
+typedef struct {    //quantile(x, q) and median(x) keep a t-digest in the aggregate context.
+    apop_tdigest *t;
+    double q;
+} QuantileCtx;
+/** \endcond */
+
+static void quantileStep(sqlite3_context *context, int argc, sqlite3_value **argv){
+    QuantileCtx *p = sqlite3_aggregate_context(context, sizeof(*p));
+    if (!p || sqlite3_value_type(argv[0]) == SQLITE_NULL) return;
+    if (!p->t) p->t = apop_tdigest_alloc(0);
+    apop_tdigest_add(p->t, sqlite3_value_double(argv[0]), 1);
+    p->q = argc > 1 ? sqlite3_value_double(argv[1]) : 0.5;
+}
+
+static void quantileFinalize(sqlite3_context *context){
+    QuantileCtx *p = sqlite3_aggregate_context(context, 0);
+    if (!p || !p->t) return; //no rows, so the result is NULL.
+    sqlite3_result_double(context, apop_tdigest_quantile(p->t, p->q));
+    apop_tdigest_free(p->t);
+}
+
 static void powFn(sqlite3_context *context, int argc, sqlite3_value **argv){
     double base = sqlite3_value_double(argv[0]);
     double exp  = sqlite3_value_double(argv[1]);
@@ -161,6 +183,8 @@ static int apop_sqlite_db_open(char const *filename){
 	sqlite3_create_function(db, "skew", 1, SQLITE_ANY, NULL, NULL, &threeStep, &skewFinalize);
 	sqlite3_create_function(db, "kurt", 1, SQLITE_ANY, NULL, NULL, &fourStep, &kurtFinalize);
 	sqlite3_create_function(db, "kurtosis", 1, SQLITE_ANY, NULL, NULL, &fourStep, &kurtFinalize);
+	sqlite3_create_function(db, "quantile", 2, SQLITE_ANY, NULL, NULL, &quantileStep, &quantileFinalize);
+	sqlite3_create_function(db, "median", 1, SQLITE_ANY, NULL, NULL, &quantileStep, &quantileFinalize);
 	sqlite3_create_function(db, "ln", 1, SQLITE_ANY, NULL, &logFn, NULL, NULL);
 	sqlite3_create_function(db, "ran", 0, SQLITE_ANY, NULL, &rngFn, NULL, NULL);
 	sqlite3_create_function(db, "pow", 2, SQLITE_ANY, NULL, &powFn, NULL, NULL);
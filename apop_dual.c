@@ -0,0 +1,89 @@
+/** \file
+  Dual numbers, for forward-mode automatic differentiation of log likelihoods. */
+/* Copyright (c) 2026 by Ben Klemens.  Licensed under the GPLv2; see COPYING.  */
+
+#include "apop_internal.h"
+
+/** A constant, whose derivative is zero. */
+apop_dual apop_dual_const(double x){ return (apop_dual){.val=x}; }
+
+/** \f$a+b\f$ */
+apop_dual apop_dual_add(apop_dual a, apop_dual b){ return (apop_dual){a.val+b.val, a.dx+b.dx}; }
+
+/** \f$a-b\f$ */
+apop_dual apop_dual_sub(apop_dual a, apop_dual b){ return (apop_dual){a.val-b.val, a.dx-b.dx}; }
+
+/** \f$ab\f$ */
+apop_dual apop_dual_mul(apop_dual a, apop_dual b){
+    return (apop_dual){a.val*b.val, a.dx*b.val + a.val*b.dx};
+}
+
+/** \f$a/b\f$ */
+apop_dual apop_dual_div(apop_dual a, apop_dual b){
+    return (apop_dual){a.val/b.val, (a.dx*b.val - a.val*b.dx)/(b.val*b.val)};
+}
+
+/** \f$sa\f$, for a constant \f$s\f$. */
+apop_dual apop_dual_scale(apop_dual a, double s){ return (apop_dual){a.val*s, a.dx*s}; }
+
+/** \f$e^a\f$ */
+apop_dual apop_dual_exp(apop_dual a){
+    double e = exp(a.val);
+    return (apop_dual){e, e*a.dx};
+}
+
+/** \f$\ln(a)\f$ */
+apop_dual apop_dual_log(apop_dual a){ return (apop_dual){log(a.val), a.dx/a.val}; }
+
+/** \f$\sqrt{a}\f$ */
+apop_dual apop_dual_sqrt(apop_dual a){
+    double s = sqrt(a.val);
+    return (apop_dual){s, a.dx/(2*s)};
+}
+
+/** \f$\ln(\Gamma(a))\f$, whose derivative is the digamma function. */
+apop_dual apop_dual_lgamma(apop_dual a){
+    return (apop_dual){lgamma(a.val), a.dx ? a.dx*gsl_sf_psi(a.val) : 0};
+}
+
+/** \f$a^b\f$. If the exponent is a constant, the base may be negative. */
+apop_dual apop_dual_pow(apop_dual a, apop_dual b){
+    double p = pow(a.val, b.val);
+    double dx = b.dx ? p * (b.dx*log(a.val) + b.val*a.dx/a.val)
+                     : (a.dx ? b.val*pow(a.val, b.val-1)*a.dx : 0);
+    return (apop_dual){p, dx};
+}
+
+/** \f$\Phi(a)\f$, the CDF of the standard Normal distribution. */
+apop_dual apop_dual_normal_cdf(apop_dual a){
+    return (apop_dual){gsl_cdf_gaussian_P(a.val, 1), a.dx*gsl_ran_gaussian_pdf(a.val, 1)};
+}
+
+/** Find the gradient of a model's log likelihood using the dual-number log likelihood
+registered for it; see \ref dualsec.
+
+\param d    The \ref apop_data set at which the score is being evaluated.
+\param out  The gradient, in \ref apop_data_pack order. I expect you to have allocated this already.
+\param m    The parametrized model.
+
+\return 0 on success; 1 if no dual log likelihood is registered for the model, in which
+case \c out is unchanged.
+*/
+int apop_dual_score(apop_data *d, gsl_vector *out, apop_model *m){
+    Nullcheck_mp(m, 1);
+    apop_dual_ll_type dual_ll = apop_dual_ll_vtable_get(m);
+    if (!dual_ll) return 1;
+    gsl_vector *p = apop_data_pack(m->parameters);
+    Apop_stopif(p->size != out->size, gsl_vector_free(p); return 1, 0, "The output vector has "
+            "%zu elements, but the model has %zu parameters.", out->size, p->size);
+    apop_dual *params = malloc(sizeof(apop_dual)*p->size);
+    for (size_t k=0; k< p->size; k++) params[k] = (apop_dual){.val=p->data[k]};
+    for (size_t j=0; j< p->size; j++){
+        params[j].dx = 1;
+        gsl_vector_set(out, j, dual_ll(d, params, m).dx);
+        params[j].dx = 0;
+    }
+    free(params);
+    gsl_vector_free(p);
+    return 0;
+}
@@ -355,23 +355,294 @@ APOP_VAR_ENDHEAD
     return out;
 }
 
+/* Rolling-window statistics. The window slides one element at a time; each step adds
+the elements entering at the top and removes those leaving at the bottom, so each
+statistic needs only an incremental update:
+
+--Mean, variance, and covariance: running moments, with Welford-style add and remove.
+  To keep rounding error from piling up over a long series, the moments are recomputed
+  from the window once per window-length of removals, which is O(1) amortized.
+--Min and max: a monotone deque of element indices, so the front is always the extreme.
+--Median and quantiles: two heaps, a max-heap of the lower part and a min-heap of the
+  upper part, kept at the sizes the rank requires. Heaps are indexed, so the element
+  leaving the window is removed in O(log window). 
+
+Elements are stored by index; index j lives in slot j % window of the per-slot arrays.
+A NaN in the window makes that window's statistic NaN. */
+
+typedef struct {
+    size_t *elmts, ct;
+    int sign;    //+1 for a max-heap, -1 for a min-heap.
+} iheap;
+
+typedef struct {
+    double const *x, *y;
+    size_t xstride, ystride, window;
+    char stat;
+    double q;
+    size_t nan_ct, lo, hi;    //The window is [lo, hi).
+    //moments
+    double n, xmean, ymean, m2, since_refresh;
+    //deque
+    size_t *dq, dq_head, dq_ct;
+    //heaps
+    iheap low, high;
+    size_t *heap_pos;
+    char *heap_side;
+} roller;
+
+#define Rx(r, j) ((r)->x[(j)*(r)->xstride])
+#define Ry(r, j) ((r)->y[(j)*(r)->ystride])
+
+static int heap_above(roller *r, iheap *h, size_t a, size_t b){ return h->sign*(Rx(r, a) - Rx(r, b)) > 0; }
+
+static void heap_swap(roller *r, iheap *h, size_t i, size_t j){
+    size_t t = h->elmts[i]; h->elmts[i] = h->elmts[j]; h->elmts[j] = t;
+    r->heap_pos[h->elmts[i] % r->window] = i;
+    r->heap_pos[h->elmts[j] % r->window] = j;
+}
+
+static void heap_fix(roller *r, iheap *h, size_t i){
+    while (i && heap_above(r, h, h->elmts[i], h->elmts[(i-1)/2])){
+        heap_swap(r, h, i, (i-1)/2);
+        i = (i-1)/2;
+    }
+    while (1){
+        size_t best = i, kid = 2*i+1;
+        if (kid < h->ct && heap_above(r, h, h->elmts[kid], h->elmts[best])) best = kid;
+        if (kid+1 < h->ct && heap_above(r, h, h->elmts[kid+1], h->elmts[best])) best = kid+1;
+        if (best == i) return;
+        heap_swap(r, h, i, best);
+        i = best;
+    }
+}
+
+static void heap_push(roller *r, iheap *h, size_t j){
+    h->elmts[h->ct] = j;
+    r->heap_pos[j % r->window] = h->ct;
+    r->heap_side[j % r->window] = (h == &r->low) ? 'l' : 'h';
+    heap_fix(r, h, h->ct++);
+}
+
+static void heap_remove_at(roller *r, iheap *h, size_t i){
+    heap_swap(r, h, i, --h->ct);
+    if (i < h->ct) heap_fix(r, h, i);
+}
+
+static void heap_rebalance(roller *r){
+    size_t m = r->low.ct + r->high.ct;
+    if (!m) return;
+    size_t want = (size_t)(r->q*(m-1)) + 1; //the lower heap holds ranks 0 ... floor(q(m-1)).
+    while (r->low.ct > want){
+        size_t j = r->low.elmts[0];
+        heap_remove_at(r, &r->low, 0);
+        heap_push(r, &r->high, j);
+    }
+    while (r->low.ct < want){
+        size_t j = r->high.elmts[0];
+        heap_remove_at(r, &r->high, 0);
+        heap_push(r, &r->low, j);
+    }
+}
+
+static void moments_refresh(roller *r){
+    r->n = r->xmean = r->ymean = r->m2 = r->since_refresh = 0;
+    for (size_t j=r->lo; j< r->hi; j++)
+        if (!isnan(Rx(r, j)) && !(r->y && isnan(Ry(r, j)))){
+            r->n++;
+            r->xmean += Rx(r, j);
+            if (r->y) r->ymean += Ry(r, j);
+        }
+    if (!r->n) return;
+    r->xmean /= r->n;
+    r->ymean /= r->n;
+    for (size_t j=r->lo; j< r->hi; j++)
+        if (!isnan(Rx(r, j)) && !(r->y && isnan(Ry(r, j))))
+            r->m2 += (Rx(r, j) - r->xmean) * (r->y ? Ry(r, j) - r->ymean : Rx(r, j) - r->xmean);
+}
+
+static void roll_add(roller *r, size_t j){
+    r->hi = j+1;
+    if (isnan(Rx(r, j)) || (r->y && isnan(Ry(r, j)))) {r->nan_ct++; return;}
+    double x = Rx(r, j);
+    if (strchr("mvsc", r->stat)){
+        r->n++;
+        double dx = x - r->xmean;
+        r->xmean += dx/r->n;
+        if (r->y){
+            double dy = Ry(r, j) - r->ymean;
+            r->ymean += dy/r->n;
+            r->m2 += dx * (Ry(r, j) - r->ymean);
+        } else r->m2 += dx * (x - r->xmean);
+    } else if (r->stat == 'n' || r->stat == 'x'){
+        int sign = r->stat == 'n' ? 1 : -1; //pop back while the back is no better than x.
+        while (r->dq_ct && sign*(Rx(r, r->dq[(r->dq_head + r->dq_ct-1) % r->window]) - x) >= 0) r->dq_ct--;
+        r->dq[(r->dq_head + r->dq_ct++) % r->window] = j;
+    } else {
+        if (!r->low.ct || x <= Rx(r, r->low.elmts[0])) heap_push(r, &r->low, j);
+        else heap_push(r, &r->high, j);
+        heap_rebalance(r);
+    }
+}
+
+static void roll_remove(roller *r, size_t j){
+    r->lo = j+1;
+    if (isnan(Rx(r, j)) || (r->y && isnan(Ry(r, j)))) {r->nan_ct--; return;}
+    if (strchr("mvsc", r->stat)){
+        if (++r->since_refresh >= r->window) {moments_refresh(r); return;}
+        if (!--r->n) {r->xmean = r->ymean = r->m2 = 0; return;}
+        double dx = Rx(r, j) - r->xmean;
+        r->xmean -= dx/r->n;
+        if (r->y){
+            double dy = Ry(r, j) - r->ymean;
+            r->ymean -= dy/r->n;
+            r->m2 -= dx * (Ry(r, j) - r->ymean);
+        } else r->m2 -= dx * (Rx(r, j) - r->xmean);
+    } else if (r->stat == 'n' || r->stat == 'x'){
+        if (r->dq_ct && r->dq[r->dq_head] == j){
+            r->dq_head = (r->dq_head+1) % r->window;
+            r->dq_ct--;
+        }
+    } else {
+        size_t slot = j % r->window;
+        heap_remove_at(r, r->heap_side[slot] == 'l' ? &r->low : &r->high, r->heap_pos[slot]);
+        heap_rebalance(r);
+    }
+}
+
+static double roll_value(roller *r){
+    if (r->nan_ct) return GSL_NAN;
+    switch (r->stat){
+        case 'm': return r->n ? r->xmean : GSL_NAN;
+        case 'v': return r->n > 1 ? r->m2/(r->n-1) : GSL_NAN;
+        case 's': return r->n > 1 ? sqrt(GSL_MAX(r->m2, 0)/(r->n-1)) : GSL_NAN;
+        case 'c': return r->n > 1 ? r->m2/(r->n-1) : GSL_NAN;
+        case 'n': case 'x': return r->dq_ct ? Rx(r, r->dq[r->dq_head]) : GSL_NAN;
+    }
+    size_t m = r->low.ct + r->high.ct;
+    if (!m) return GSL_NAN;
+    double lower = Rx(r, r->low.elmts[0]);
+    return r->q*(m-1) == r->low.ct-1 ? lower : (lower + Rx(r, r->high.elmts[0]))/2.;
+}
+
+static gsl_vector *rolling_core(gsl_vector const *x, gsl_vector const *y, size_t window,
+                                    char stat, double q, char align, char edge){
+    size_t n = x->size;
+    size_t full_ct = n >= window ? n - window + 1 : 0;
+    Apop_stopif(edge == 't' && !full_ct, return NULL, 0, "The window (%zu) is longer than "
+            "the data (%zu), so there are no full windows. Returning NULL.", window, n);
+    roller r = {.x=x->data, .xstride=x->stride, .y=y ? y->data : NULL, .ystride=y ? y->stride : 0,
+                .window=window, .stat=stat, .q=stat=='d' ? 0.5 : q,
+                .low={.sign=1}, .high={.sign=-1}};
+    if (stat == 'n' || stat == 'x') r.dq = malloc(sizeof(size_t)*window);
+    if (stat == 'd' || stat == 'q'){
+        r.low.elmts = malloc(sizeof(size_t)*window);
+        r.high.elmts = malloc(sizeof(size_t)*window);
+        r.heap_pos = malloc(sizeof(size_t)*window);
+        r.heap_side = malloc(window);
+    }
+    gsl_vector *out = gsl_vector_alloc(edge == 't' ? full_ct : n);
+    size_t outpos = 0;
+    for (size_t i=0; i< n; i++){
+        ptrdiff_t wlo = align == 'c' ? (ptrdiff_t)i - (ptrdiff_t)window/2 : (ptrdiff_t)i - (ptrdiff_t)window + 1;
+        ptrdiff_t whi = wlo + window;
+        size_t lo = GSL_MAX(wlo, 0), hi = GSL_MIN(whi, (ptrdiff_t)n);
+        while (r.lo < lo && r.lo < r.hi) roll_remove(&r, r.lo);
+        r.lo = GSL_MAX(r.lo, lo);
+        if (r.hi < r.lo) r.hi = r.lo;
+        while (r.hi < hi) roll_add(&r, r.hi);
+        int full = wlo >= 0 && whi <= (ptrdiff_t)n;
+        if (edge == 't'){
+            if (full) gsl_vector_set(out, outpos++, roll_value(&r));
+        } else gsl_vector_set(out, i, (full || edge == 'p') ? roll_value(&r) : GSL_NAN);
+    }
+    free(r.dq);
+    free(r.low.elmts); free(r.high.elmts);
+    free(r.heap_pos); free(r.heap_side);
+    return out;
+}
+
+/** Statistics over a window that rolls along a vector: a moving mean, variance,
+standard deviation, minimum, maximum, median, or quantile.
+
+Each statistic is updated incrementally as the window slides, so the cost per element
+is \f$O(1)\f$ (mean, variance, min, max; amortized) or \f$O(\log w)\f$ (median and
+quantiles) for a window of length \f$w\f$, rather than \f$O(w)\f$.
+
+\param v The input vector. (No default, must not be \c NULL)
+\param window The number of elements in each window. (No default, must be at least one)
+\param stat Which statistic:
+ - 'm': mean (the default)
+ - 'v': sample variance (dividing by \f$n-1\f$)
+ - 's': sample standard deviation
+ - 'n': minimum
+ - 'x': maximum
+ - 'd': median
+ - 'q': the quantile given by \c q
+\param q For \c stat='q', the quantile, in \f$[0,1]\f$. When it falls between two
+elements, give their mean, as per the \c 'a' rounding of \ref apop_vector_percentiles. (default = 0.5)
+\param align
+ - 't': a trailing window: output element \f$i\f$ summarizes input elements \f$i-w+1\f$ through \f$i\f$. (the default)
+ - 'c': a centered window: elements \f$i-\lfloor w/2\rfloor\f$ through \f$i-\lfloor w/2\rfloor+w-1\f$.
+\param edge What to do where the window runs past the ends of the data:
+ - 'n': the output is the same length as the input, with NaN wherever the window is incomplete. (the default)
+ - 'p': the output is the same length as the input, and incomplete windows are summarized using the elements they have.
+ - 't': trim; the output holds only the \f$n-w+1\f$ full windows.
+
+\return A new vector, or \c NULL on error.
+\li A window containing a NaN gives NaN.
+\li For the covariance between two series, see \ref apop_vector_rolling_cov.
+\li This function uses the \ref designated syntax for inputs.
+*/
+APOP_VAR_HEAD gsl_vector *apop_vector_rolling(gsl_vector const *v, size_t window, char stat, double q, char align, char edge){
+    gsl_vector const * apop_varad_var(v, NULL);
+    Apop_stopif(!v, return NULL, 0, "You sent me a NULL vector; returning NULL.");
+    size_t apop_varad_var(window, 0);
+    Apop_stopif(!window, return NULL, 0, "The window must be at least one element long; returning NULL.");
+    char apop_varad_var(stat, 'm');
+    Apop_stopif(!strchr("mvsnxdq", stat), return NULL, 0, "I don't know the statistic '%c'; returning NULL.", stat);
+    double apop_varad_var(q, 0.5);
+    Apop_stopif(!(q >= 0 && q <= 1), return NULL, 0, "The quantile must be in [0, 1]; returning NULL.");
+    char apop_varad_var(align, 't');
+    char apop_varad_var(edge, 'n');
+APOP_VAR_ENDHEAD
+    return rolling_core(v, NULL, window, stat, q, align, edge);
+}
+
+/** The sample covariance of two vectors over a rolling window. See \ref apop_vector_rolling
+for the details of windows and edges, which work the same way here.
+
+\param v1, v2 The two series, of equal length. (No default, must not be \c NULL)
+\param window The number of elements in each window. (No default, must be at least one)
+\param align 't' for a trailing window (the default), 'c' for centered.
+\param edge 'n' for NaNs where the window is incomplete (the default), 'p' for partial windows, 't' to trim to full windows only.
+\li This function uses the \ref designated syntax for inputs.
+*/
+APOP_VAR_HEAD gsl_vector *apop_vector_rolling_cov(gsl_vector const *v1, gsl_vector const *v2, size_t window, char align, char edge){
+    gsl_vector const * apop_varad_var(v1, NULL);
+    gsl_vector const * apop_varad_var(v2, NULL);
+    Apop_stopif(!v1 || !v2, return NULL, 0, "You sent me a NULL vector; returning NULL.");
+    Apop_stopif(v1->size != v2->size, return NULL, 0, "The vectors have sizes %zu and %zu; returning NULL.", v1->size, v2->size);
+    size_t apop_varad_var(window, 0);
+    Apop_stopif(!window, return NULL, 0, "The window must be at least one element long; returning NULL.");
+    char apop_varad_var(align, 't');
+    char apop_varad_var(edge, 'n');
+APOP_VAR_ENDHEAD
+    return rolling_core(v1, v2, window, 'c', 0, align, edge);
+}
+
 /** Return a new vector that is the moving average of the input vector.
 
 \param v The input vector, unsmoothed
 \param bandwidth An integer \f$\geq 1\f$ giving the number of elements to be averaged to produce one number.
 \return A smoothed vector of size <tt>v->size - (bandwidth/2)*2</tt>.
+\li Each output element is the mean of a centered window of <tt>(bandwidth/2)*2+1</tt> elements,
+found via a running sum; see \ref apop_vector_rolling for more options.
  */
 gsl_vector *apop_vector_moving_average(gsl_vector *v, size_t bandwidth){
     Apop_stopif(!v, return NULL, 0, "You asked me to smooth a NULL vector; returning NULL.");
     Apop_stopif(!bandwidth, return apop_vector_copy(v), 0, "Bandwidth must be >=1. Returning a copy of original vector with no smoothing.");
     int halfspan = bandwidth/2;
-    Apop_stopif((v->size - halfspan*2)<=0, return NULL, 0, "Bandwidth wider than the vector. Returning NULL.");
-    gsl_vector *vout = gsl_vector_calloc(v->size - halfspan*2);
-    for(size_t i=0; i < vout->size; i ++){
-        double *item = gsl_vector_ptr(vout, i);
-        for (int j=-halfspan; j < halfspan+1; j ++)
-            *item += gsl_vector_get(v, j+ i+ halfspan);
-        *item /= halfspan*2 +1;
-    }
-    return vout;
+    Apop_stopif(v->size <= halfspan*2, return NULL, 0, "Bandwidth wider than the vector. Returning NULL.");
+    return rolling_core(v, NULL, halfspan*2+1, 'm', 0, 'c', 't');
 }
@@ -55,14 +55,31 @@ void apop_gsl_error(char const *reason, char const *file, int line, int gsl_errn
 #endif
 
 #ifdef _OPENMP
+#include <omp.h>
 #define PRAGMA(x) _Pragma(#x)
 #define OMP_critical(tag) PRAGMA(omp critical ( tag ))
+#define OMP_atomic _Pragma("omp atomic")
+#define OMP_atomic_read _Pragma("omp atomic read seq_cst")
+#define OMP_atomic_write _Pragma("omp atomic write seq_cst")
 #define OMP_for(...) _Pragma("omp parallel for") for(__VA_ARGS__)
 #define OMP_for_reduce(red, ...) PRAGMA(omp parallel for reduction( red )) for(__VA_ARGS__)
+#define OMP_parallel(...) PRAGMA(omp parallel __VA_ARGS__)
+#define OMP_team_for(...) _Pragma("omp for") for(__VA_ARGS__)
+#define omp_threadnum omp_get_thread_num()
+#define omp_maxthreads omp_get_max_threads()
+#define omp_inparallel omp_in_parallel()
 #else
 #define OMP_critical(tag)
+#define OMP_atomic
+#define OMP_atomic_read
+#define OMP_atomic_write
 #define OMP_for(...) for(__VA_ARGS__)
 #define OMP_for_reduce(red, ...) for(__VA_ARGS__)
+#define OMP_parallel(...)
+#define OMP_team_for(...) for(__VA_ARGS__)
+#define omp_threadnum 0
+#define omp_maxthreads 1
+#define omp_inparallel 0
 #endif
 
 #include "config.h"
@@ -84,3 +101,8 @@ extern int vasprintf (char **res, const char *format, va_list args)
 void add_info_criteria(apop_data *d, apop_model *m, apop_model *est, double ll, int param_ct); //In apop_mle.c
 
 apop_model *maybe_prep(apop_data *d, apop_model *m, _Bool *is_a_copy); //in apop_mcmc, for apop_update.
+void apop_mcmc_draw_setup(apop_model *m); //in apop_mcmc, for apop_draw.
+long double apop_compensated_sum(double const *x, size_t stride, size_t n); //in apop_stats.
+void apop_fused_moments(double const *x, size_t xstride, double const *w, size_t wstride,
+                          size_t n, long double *wsum, long double *mean, long double *m2); //in apop_stats.
+void apop_percentiles_select(gsl_vector const *data, char rounding, int const *pcts, int ct, double *out); //in apop_stats.
@@ -12,11 +12,31 @@ void apop_gsl_error(const char *reason, const char *file, int line, int gsl_errn
     Apop_maybe_abort(1);
 }
 #define Checkgsl(...) if (__VA_ARGS__) {goto done;}
-#define Check_gsl_with_out(...) if (__VA_ARGS__) {out->error='m'; goto done;}
-#define Check_gsl_with_outmp(...) if (__VA_ARGS__) {gsl_matrix_free(*out); *out=NULL; goto done;}
 #define Set_gsl_handler gsl_error_handler_t *prior_handler = gsl_set_error_handler(apop_gsl_error);
 #define Unset_gsl_handler gsl_set_error_handler(prior_handler);
 
+/* LU-decompose a copy of the square matrix in; if inv isn't NULL, write the inverse
+there (inv may be in); if det isn't NULL, write the determinant there. Returns 0 on
+success, 1 on a GSL error, with *det left as it was. */
+static int lu_det_and_inv(const gsl_matrix *in, gsl_matrix *inv, double *det){
+    Set_gsl_handler
+    int sign, status = 1;
+	gsl_matrix *invert_me = gsl_matrix_alloc(in->size1, in->size1);
+	gsl_permutation * perm = gsl_permutation_alloc(in->size1);
+	gsl_matrix_memcpy (invert_me, in);
+	Checkgsl(gsl_linalg_LU_decomp(invert_me, perm, &sign))
+	if (inv)
+		Checkgsl(gsl_linalg_LU_invert(invert_me, perm, inv))
+	if (det)
+		*det = gsl_linalg_LU_det(invert_me, sign);
+    status = 0;
+    done:
+	gsl_matrix_free(invert_me);
+	gsl_permutation_free(perm);
+    Unset_gsl_handler
+	return status;
+}
+
 /**
 Calculate the determinant of a matrix, its inverse, or both, via LU decomposition. The \c in matrix is not destroyed in the process.
 
@@ -38,34 +58,47 @@ then \c *out is pointed to the matrix inverse. In case of difficulty, I will set
 */
 
 double apop_det_and_inv(const gsl_matrix *in, gsl_matrix **out, int calc_det, int calc_inv) {
-    Set_gsl_handler
-    Apop_stopif(in->size1 != in->size2, *out=NULL; return GSL_NAN, 0, "You asked me to invert a %zu X %zu matrix, "
+    Apop_stopif(in->size1 != in->size2, if (calc_inv) *out=NULL; return GSL_NAN, 0, "You asked me to invert a %zu X %zu matrix, "
             "but inversion requires a square matrix.", in->size1, in->size2);
-    int sign;
     double the_determinant = GSL_NAN;
-	gsl_matrix *invert_me = gsl_matrix_alloc(in->size1, in->size1);
-	gsl_permutation * perm = gsl_permutation_alloc(in->size1);
-	gsl_matrix_memcpy (invert_me, in);
-	Checkgsl(gsl_linalg_LU_decomp(invert_me, perm, &sign))
-	if (calc_inv){
+	if (calc_inv)
 		*out = gsl_matrix_alloc(in->size1, in->size1); //square.
-		Check_gsl_with_outmp(gsl_linalg_LU_invert(invert_me, perm, *out))
+    if (lu_det_and_inv(in, calc_inv ? *out : NULL, calc_det ? &the_determinant : NULL) && calc_inv){
+        gsl_matrix_free(*out);
+        *out = NULL;
     }
-	if (calc_det)
-		the_determinant	= gsl_linalg_LU_det(invert_me, sign);
-    done:
-	gsl_matrix_free(invert_me);
-	gsl_permutation_free(perm);
-    Unset_gsl_handler
 	return the_determinant;
 }
 
+/**
+Inverts a matrix, writing the inverse into a matrix you have already allocated, so
+repeated inversions of same-sized matrices needn't allocate a new matrix each time.
+
+\param in The matrix to be inverted. It is not modified (unless it is also \c out).
+\param out A matrix of the same size as \c in, to be filled with the inverse. This may be
+\c in itself, to invert in place.
+\param det If not \c NULL, the determinant of \c in is written here.
+\return 0 on success; 1 if the matrix is not square, is singular, or \c out is the wrong
+size, in which case the contents of \c out are undefined and \c *det is \c NaN.
+\see apop_matrix_inverse, apop_det_and_inv
+*/
+int apop_matrix_inverse_into(const gsl_matrix *in, gsl_matrix *out, double *det){
+    if (det) *det = GSL_NAN;
+    Apop_stopif(in->size1 != in->size2, return 1, 0, "You asked me to invert a %zu X %zu matrix, "
+            "but inversion requires a square matrix.", in->size1, in->size2);
+    Apop_stopif(out->size1 != in->size1 || out->size2 != in->size2, return 1, 0,
+            "The output matrix is %zu X %zu, but the inverse will be %zu X %zu.",
+            out->size1, out->size2, in->size1, in->size2);
+    return lu_det_and_inv(in, out, det);
+}
+
 /**
 Inverts a matrix. The \c in matrix is not destroyed in the process.
 You may want to call \ref apop_matrix_determinant first to check that your input is invertible, or use \ref apop_det_and_inv to do both at once.
 
 \param in The matrix to be inverted.
 \return Its inverse.
+\see apop_matrix_inverse_into to write the inverse into an existing matrix.
 */
 gsl_matrix * apop_matrix_inverse(const gsl_matrix *in) {
     gsl_matrix *out = NULL;
@@ -85,6 +118,73 @@ double apop_matrix_determinant(const gsl_matrix *in) {
     return apop_det_and_inv(in, NULL, 1, 0);
 }
 
+/* Orthonormalize the columns of m in place, by classical Gram-Schmidt with one round of
+reorthogonalization, which is enough to keep the columns orthogonal to working
+precision. A column that is (numerically) in the span of the ones before it is zeroed. */
+static void orthonormalize(gsl_matrix *m){
+    gsl_vector *coeffs = gsl_vector_alloc(m->size2);
+    for (size_t j=0; j< m->size2; j++){
+        gsl_vector *v = Apop_mcv(m, j);
+        double norm0 = gsl_blas_dnrm2(v);
+        if (j) for (int pass=0; pass< 2; pass++){
+            gsl_matrix *prior = Apop_subm(m, 0, 0, m->size1, j);
+            gsl_vector *c = Apop_subvector(coeffs, 0, j);
+            gsl_blas_dgemv(CblasTrans, 1, prior, v, 0, c);
+            gsl_blas_dgemv(CblasNoTrans, -1, prior, c, 1, v);
+        }
+        double norm = gsl_blas_dnrm2(v);
+        if (norm > 1e-10*norm0) gsl_vector_scale(v, 1/norm);
+        else gsl_vector_set_zero(v);
+    }
+    gsl_vector_free(coeffs);
+}
+
+/* The randomized range finder of Halko, Martinsson, and Tropp, <em>Finding structure with
+randomness</em> (2011), algorithms 4.4 and 5.1. Find an orthonormal basis Q for the
+range of X times a random Gaussian matrix, sharpened by power iterations against
+X'X; then the SVD of the small matrix X'Q gives the leading right singular vectors
+of X, which are the leading eigenvectors of X'X. Fills the first evectors->size2 columns
+of evectors and the matching elements of evalues (as eigenvalues of X'X). */
+#define Pca_oversample 10
+
+static int randomized_pca(gsl_matrix const *data, gsl_matrix *evectors, gsl_vector *evalues,
+                            int power_iterations, gsl_rng *rng){
+    size_t cols = data->size2, want = evectors->size2;
+    size_t l = GSL_MIN(want + Pca_oversample, cols);
+    gsl_matrix *omega = gsl_matrix_alloc(cols, l);
+    gsl_matrix *q     = gsl_matrix_alloc(data->size1, l);
+    gsl_matrix *bt    = gsl_matrix_alloc(cols, l);
+    gsl_matrix *v     = gsl_matrix_alloc(l, l);
+    gsl_vector *svals = gsl_vector_alloc(l);
+    gsl_vector *work  = gsl_vector_alloc(l);
+    int status = 1;
+    Apop_stopif(!omega || !q || !bt || !v || !svals || !work, goto done, 0,
+            "Allocation error setting up a %zu X %zu workspace.", data->size1, l);
+    for (size_t i=0; i< cols; i++)
+        for (size_t j=0; j< l; j++)
+            gsl_matrix_set(omega, i, j, gsl_ran_gaussian(rng, 1));
+	Checkgsl(gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1, data, omega, 0, q))
+    orthonormalize(q);
+    for (int i=0; i< power_iterations; i++){
+        Checkgsl(gsl_blas_dgemm(CblasTrans, CblasNoTrans, 1, data, q, 0, omega))
+        orthonormalize(omega);
+        Checkgsl(gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1, data, omega, 0, q))
+        orthonormalize(q);
+    }
+	Checkgsl(gsl_blas_dgemm(CblasTrans, CblasNoTrans, 1, data, q, 0, bt))
+	Checkgsl(gsl_linalg_SV_decomp(bt, v, svals, work)) //bt is now the left singular vectors of X'Q.
+    for (size_t i=0; i< want; i++){
+        gsl_matrix_set_col(evectors, i, Apop_mcv(bt, i));
+        gsl_vector_set(evalues, i, gsl_pow_2(gsl_vector_get(svals, i)));
+    }
+    status = 0;
+    done:
+    gsl_matrix_free(omega); gsl_matrix_free(q);
+    gsl_matrix_free(bt);    gsl_matrix_free(v);
+    gsl_vector_free(svals); gsl_vector_free(work);
+    return status;
+}
+
 /** Principal component analysis: hand in a matrix and (optionally) a number of desired dimensions, and I'll return a data set where each column of the matrix is an eigenvector. The columns are sorted, so column zero has the greatest weight. The vector element of the data set gives the weights.
 
 You may also specify the number of elements your principal component space should have. If
@@ -99,43 +199,92 @@ mean zero. (No default. If \c NULL, return \c NULL and print a warning iff
 
 \param dimensions_we_want The singular value decomposition will return this many of the eigenvectors with the largest eigenvalues. (default: the size of the covariance matrix, i.e. <tt>data->size2</tt>)
 
+\param method
+ - \c 'e': Exact. Form the \f$k\times k\f$ cross-product matrix of the \f$k\f$ columns and decompose it in full. (default)
+ - \c 'r': Randomized and truncated. Find the leading components via a randomized range
+finder with power iterations, at a cost of about \f$O(nkd)\f$ for \f$d\f$ dimensions,
+rather than the \f$O(nk^2 + k^3)\f$ of the exact method. The leading components match
+those of the exact method to within a small tolerance when the eigenvalues are well
+separated; accuracy falls off for the trailing components requested, and improves with
+more power iterations. Use this when you want a few components of a wide data set.
+
+\param power_iterations For the randomized method, the number of rounds of power
+iteration, each costing two passes over the data. (default: 2)
+
+\param rng For the randomized method, the RNG used to generate the random projection.
+(default: an RNG from \ref apop_rng_get_thread)
+
 \return  Returns an \ref apop_data set whose matrix is the principal component
 space. Each column of the returned matrix will be another eigenvector; the columns
 will be ordered by the eigenvalues.
 
 The data set's vector will be the largest eigenvalues, scaled by the total of all eigenvalues (including those that were thrown out). The sum of these returned values will give you the percentage of variance explained by the factor analysis.
 
+A second page, named <tt>\<Eigenvalues\></tt>, has a vector holding the eigenvalues
+themselves, as variances: the eigenvalues of the covariance matrix of the columns.
+
 \exception out->error=='a'  Allocation error.
+\exception out->error=='m'  Math error in the decomposition.
+\li This function uses the \ref designated syntax for inputs.
 */
-APOP_VAR_HEAD apop_data * apop_matrix_pca(gsl_matrix *data, int const dimensions_we_want) {
+APOP_VAR_HEAD apop_data * apop_matrix_pca(gsl_matrix *data, int const dimensions_we_want, char method, int power_iterations, gsl_rng *rng) {
     gsl_matrix * apop_varad_var(data, NULL);
     Apop_stopif(!data, return NULL, 1, "NULL data input");
     int const apop_varad_var(dimensions_we_want, data->size2);
+    Apop_stopif(dimensions_we_want < 1 || dimensions_we_want > data->size2, return NULL, 0,
+            "You asked for %i dimensions from data with %zu columns. Returning NULL.", dimensions_we_want, data->size2);
+    char apop_varad_var(method, 'e');
+    Apop_stopif(method != 'e' && method != 'r', return NULL, 0, "I don't know the method '%c'. Returning NULL.", method);
+    int apop_varad_var(power_iterations, 2);
+    gsl_rng * apop_varad_var(rng, method=='r' ? apop_rng_get_thread() : NULL);
 APOP_VAR_ENDHEAD
     Set_gsl_handler
+    gsl_matrix *eigenvectors = NULL, *square = NULL;
+    gsl_vector *dummy_v = NULL, *all_evalues = NULL;
     apop_data *pc_space	= apop_data_alloc(0, data->size2, dimensions_we_want);
-    Apop_stopif(pc_space->error, return pc_space, 0, "Allocation error.");
+    Apop_stopif(pc_space->error, goto done, 0, "Allocation error.");
 	pc_space->vector = gsl_vector_alloc(dimensions_we_want);
-    Apop_stopif(!pc_space->vector, pc_space->error='a'; return pc_space, 
+    Apop_stopif(!pc_space->vector, pc_space->error='a'; goto done, 
                 0, "Allocation error setting up a %i vector.", dimensions_we_want);
-    gsl_matrix *eigenvectors = gsl_matrix_alloc(data->size2, data->size2);
-    gsl_vector *dummy_v 	 = gsl_vector_alloc(data->size2);
-    gsl_vector *all_evalues  = gsl_vector_alloc(data->size2);
-    gsl_matrix *square  	 = gsl_matrix_calloc(data->size2, data->size2);
-    Apop_stopif(!eigenvectors || !dummy_v || !all_evalues || !square, pc_space->error='a'; return pc_space, 
-                0, "Allocation error setting up workspace for %zu dimensions.", data->size2);
-    double eigentotals	= 0;
+    apop_data *evalue_page = apop_data_add_page(pc_space, apop_data_alloc(dimensions_we_want), "<Eigenvalues>");
     for (int i=0; i< data->size2; i++)
         apop_vector_normalize(Apop_mcv(data, i), NULL, 'm');
+    double df = GSL_MAX(data->size1 - 1., 1);
+
+    if (method == 'r'){
+        //The total variance is the trace of X'X, so the shares explained are exact.
+        long double eigentotals = 0;
+        for (size_t i=0; i< data->size1; i++)
+            for (size_t j=0; j< data->size2; j++)
+                eigentotals += gsl_pow_2(data->data[i*data->tda + j]);
+        Apop_stopif(randomized_pca(data, pc_space->matrix, evalue_page->vector, power_iterations, rng),
+                pc_space->error='m'; goto done, 0, "Trouble in the randomized decomposition.");
+        gsl_vector_memcpy(pc_space->vector, evalue_page->vector);
+        gsl_vector_scale(pc_space->vector, 1/(double)eigentotals);
+        gsl_vector_scale(evalue_page->vector, 1/df);
+        Unset_gsl_handler
+        return pc_space;
+    }
+
+    eigenvectors = gsl_matrix_alloc(data->size2, data->size2);
+    dummy_v      = gsl_vector_alloc(data->size2);
+    all_evalues  = gsl_vector_alloc(data->size2);
+    square       = gsl_matrix_calloc(data->size2, data->size2);
+    Apop_stopif(!eigenvectors || !dummy_v || !all_evalues || !square, pc_space->error='a'; goto done, 
+                0, "Allocation error setting up workspace for %zu dimensions.", data->size2);
+    double eigentotals	= 0;
 
-	Checkgsl(gsl_blas_dgemm(CblasTrans,CblasNoTrans, 1, data, data, 0, square))
-	Checkgsl(gsl_linalg_SV_decomp(square, eigenvectors, all_evalues, dummy_v))
+    Apop_stopif(gsl_blas_dgemm(CblasTrans,CblasNoTrans, 1, data, data, 0, square),
+                pc_space->error='m'; goto done, 0, "Trouble forming the cross-product matrix.");
+    Apop_stopif(gsl_linalg_SV_decomp(square, eigenvectors, all_evalues, dummy_v),
+                pc_space->error='m'; goto done, 0, "Trouble in the singular value decomposition.");
 	for (int i=0; i< all_evalues->size; i++)
 		eigentotals	+= gsl_vector_get(all_evalues, i);
 	for (int i=0; i<dimensions_we_want; i++){
 		gsl_vector *v = Apop_cv(&(apop_data){.matrix=eigenvectors}, i);
 		gsl_matrix_set_col(pc_space->matrix, i, v);
 		gsl_vector_set(pc_space->vector, i, gsl_vector_get(all_evalues, i)/eigentotals);
+		gsl_vector_set(evalue_page->vector, i, gsl_vector_get(all_evalues, i)/df);
 	}
     done:
 	gsl_vector_free(dummy_v); 	gsl_vector_free(all_evalues);
@@ -319,14 +468,80 @@ APOP_VAR_END_HEAD
 }
 
 
-static gsl_vector* dot_for_apop_dot(const gsl_matrix *m, const gsl_vector *v, 
-                             const CBLAS_TRANSPOSE_t flip){
-    #define Check_gslv(...) if (__VA_ARGS__) {gsl_vector_free(out); out=NULL;}
-    gsl_vector *out = (flip ==CblasNoTrans)
-                        ? gsl_vector_calloc(m->size1)
-                        : gsl_vector_calloc(m->size2);
-    Check_gslv(gsl_blas_dgemv (flip, 1.0, m, v, 0.0, out))
-    return out;
+#define Dot_trans(form) (((form) == 'p' || (form) == 't' || (form) == 1) ? CblasTrans : CblasNoTrans)
+
+/* 1 if the dot product should use d's matrix, 0 if its vector, -1 if the part
+requested is missing. */
+static int dot_uses_matrix(const apop_data *d, char form, char const *side){
+    if (d->matrix && form != 'v') return 1;
+    if (d->vector)                return 0;
+    Apop_stopif(form == 'v', return -1, 0, "You asked for a vector from the %s data set, but "
+                "its vector==NULL. Returning NULL.", side);
+    Apop_stopif(!d->matrix, return -1, 0, "The %s data set has neither non-NULL "
+                              "matrix nor vector. Returning NULL.", side);
+    return -1;
+}
+
+/* The guts of apop_dot and apop_dot_into. If allocate=='y', the output matrix or vector is
+allocated here (without zeroing; with beta=0, BLAS never reads it); else it must be in
+place with the right size. Returns zero or an error code. */
+static char dot_base(const apop_data *d1, const apop_data *d2, int uselm, int userm, char form1, char form2,
+                        double alpha, double beta, apop_data *out, char allocate){
+    Set_gsl_handler
+    char err = 0;
+    gsl_matrix  *lm = d1->matrix, 
+                *rm = d2->matrix;
+    gsl_vector  *lv = d1->vector, 
+                *rv = d2->vector;
+    #define Dimcheck(lr, lc, rr, rc) Apop_stopif((lc)!=(rr), err='d'; goto done,\
+        0, "mismatched dimensions: %zuX%zu dot %zuX%zu. %s", (lr), (lc), (rr), (rc),\
+        ((lr)==(rr)) ? " Maybe transpose the first?" \
+        : ((rc)==(lc)) ? " Maybe transpose the second?" : "");
+    #define Outcheck(part, ...) \
+        if (allocate == 'y') {out->part = gsl_##part##_alloc(__VA_ARGS__); \
+            Apop_stopif(!out->part, err='a'; goto done, 0, "Allocation error.");} \
+        else Apop_stopif(!out->part || !Outsize_##part(out->part, __VA_ARGS__), err='d'; goto done, \
+                0, "The output " #part " is NULL or the wrong size for the product.");
+    #define Outsize_matrix(m, r, c) ((m)->size1 == (r) && (m)->size2 == (c))
+    #define Outsize_vector(v, n)    ((v)->size == (n))
+
+    CBLAS_TRANSPOSE_t lt = Dot_trans(form1), rt = Dot_trans(form2);
+    if (uselm && userm){
+        Dimcheck((lt== CblasNoTrans) ? lm->size1:lm->size2,
+                 (lt== CblasNoTrans) ? lm->size2:lm->size1,
+                 (rt== CblasNoTrans) ? rm->size1:rm->size2,
+                 (rt== CblasNoTrans) ? rm->size2:rm->size1)
+        Outcheck(matrix, (lt== CblasTrans)? lm->size2: lm->size1, 
+                         (rt== CblasTrans)? rm->size1: rm->size2)
+        Apop_stopif(gsl_blas_dgemm(lt, rt, alpha, lm, rm, beta, out->matrix), err='m'; goto done,
+                0, "GSL-level math error");
+    } else if (!uselm && userm){
+        Dimcheck((size_t)1, lv->size,
+                 (rt== CblasNoTrans) ? rm->size1:rm->size2,
+                 (rt== CblasNoTrans) ? rm->size2:rm->size1)
+        Outcheck(vector, (rt== CblasNoTrans) ? rm->size2:rm->size1)
+        //dgemv is always matrix first, then vector, so reverse from vm to mv:
+        // if output vector has dimension matrix->size2, send CblasTrans
+        // if output vector has dimension matrix->size1, send CblasNoTrans
+        Apop_stopif(gsl_blas_dgemv((rt == CblasNoTrans) ? CblasTrans : CblasNoTrans,
+                                    alpha, rm, lv, beta, out->vector), err='m'; goto done,
+                0, "GSL-level math error");
+    } else if (uselm && !userm){
+        Dimcheck((lt== CblasNoTrans) ? lm->size1:lm->size2,
+                 (lt== CblasNoTrans) ? lm->size2:lm->size1,
+                  rv->size , (size_t)1)
+        Outcheck(vector, (lt== CblasNoTrans) ? lm->size1:lm->size2)
+        Apop_stopif(gsl_blas_dgemv(lt, alpha, lm, rv, beta, out->vector), err='m'; goto done,
+                0, "GSL-level math error");
+    } else if (!uselm && !userm){ 
+        double outd;
+        Apop_stopif(gsl_blas_ddot(lv, rv, &outd), err='m'; goto done, 0, "GSL-level math error");
+        Outcheck(vector, 1)
+        gsl_vector_set(out->vector, 0, alpha*outd + (beta ? beta*gsl_vector_get(out->vector, 0) : 0));
+    }
+done:
+    Unset_gsl_handler
+    return err;
 }
 
 /** A convenience function for dot products, which requires less prep and typing than the <tt>gsl_cblas_dgexx</tt> functions.
@@ -385,75 +600,15 @@ APOP_VAR_HEAD apop_data * apop_dot(const apop_data *d1, const apop_data *d2, cha
     char apop_varad_var(form1, 0)
     char apop_varad_var(form2, 0)
 APOP_VAR_ENDHEAD
-    Set_gsl_handler
-    int         uselm, userm;
-    gsl_matrix  *lm = d1->matrix, 
-                *rm = d2->matrix;
-    gsl_vector  *lv = d1->vector, 
-                *rv = d2->vector;
-
-    if (d1->matrix && form1 != 'v') uselm = 1;
-    else if (d1->vector)            uselm = 0;
-    else {
-        Apop_stopif(form1 == 'v', return NULL, 0,
-                    "You asked for a vector from the left data set, but "
-                    "its vector==NULL. Returning NULL.");
-        Apop_stopif(1, return NULL, 0, "The left data set has neither non-NULL "
-                                  "matrix nor vector. Returning NULL.");
-    }
-    if (d2->matrix && form2 != 'v') userm = 1;
-    else if (d2->vector)            userm = 0;
-    else {
-        Apop_stopif(form2 == 'v', return NULL, 0, 
-                    "You asked for a vector from the right data set, but "
-                    "its vector==NULL. Returning NULL.");
-        Apop_stopif(1, return NULL, 0, "The right data set has neither non-NULL "
-                                  "matrix nor vector. Returning NULL.");
-    }
+    int uselm = dot_uses_matrix(d1, form1, "left");
+    int userm = dot_uses_matrix(d2, form2, "right");
+    if (uselm < 0 || userm < 0) return NULL;
     apop_data *out = apop_data_alloc();
-    #define Dimcheck(lr, lc, rr, rc) Apop_stopif((lc)!=(rr), out->error='d'; goto done,\
-        0, "mismatched dimensions: %zuX%zu dot %zuX%zu. %s", (lr), (lc), (rr), (rc),\
-        ((lr)==(rr)) ? " Maybe transpose the first?" \
-        : ((rc)==(lc)) ? " Maybe transpose the second?" : "");
-
-    CBLAS_TRANSPOSE_t lt, rt;
-    lt  = (form1 == 'p' || form1 == 't' || form1 == 1) 
-            ? CblasTrans: CblasNoTrans;
-    rt  = (form2 == 'p' || form2 == 't' || form2 == 1) 
-            ? CblasTrans: CblasNoTrans;
-    if (uselm && userm){
-        Dimcheck((lt== CblasNoTrans) ? lm->size1:lm->size2,
-                 (lt== CblasNoTrans) ? lm->size2:lm->size1,
-                 (rt== CblasNoTrans) ? rm->size1:rm->size2,
-                 (rt== CblasNoTrans) ? rm->size2:rm->size1)
-        gsl_matrix *outm = gsl_matrix_calloc((lt== CblasTrans)? lm->size2: lm->size1, 
-                                             (rt== CblasTrans)? rm->size1: rm->size2);
-        Check_gsl_with_out(gsl_blas_dgemm (lt,rt, 1, lm, rm, 0, outm))
-        out->matrix = outm;
-    } else if (!uselm && userm){
-        Dimcheck((size_t)1, lv->size,
-                 (rt== CblasNoTrans) ? rm->size1:rm->size2,
-                 (rt== CblasNoTrans) ? rm->size2:rm->size1)
-        //dgemv is always matrix first, then vector, so reverse from vm to mv:
-        // if output vector has dimension matrix->size2, send CblasTrans
-        // if output vector has dimension matrix->size1, send CblasNoTrans
-        out->vector = dot_for_apop_dot(rm, lv
-                        , (rt == CblasNoTrans) ? CblasTrans : CblasNoTrans);
-        Apop_stopif(!out->vector, out->error='m'; goto done, 0, "GSL-level math error");
-    } else if (uselm && !userm){
-        Dimcheck((lt== CblasNoTrans) ? lm->size1:lm->size2,
-                 (lt== CblasNoTrans) ? lm->size2:lm->size1,
-                  rv->size , (size_t)1)
-        out->vector = dot_for_apop_dot(lm, rv , lt);
-        Apop_stopif(!out->vector, out->error='m'; goto done, 0, "GSL-level math error");
-    } else if (!uselm && !userm){ 
-        double outd;
-        Check_gsl_with_out(gsl_blas_ddot(lv, rv, &outd))
-        out->vector = gsl_vector_alloc(1);
-        gsl_vector_set(out->vector, 0, outd);
-    }
+    out->error = dot_base(d1, d2, uselm, userm, form1, form2, 1, 0, out, 'y');
+    if (out->error) return out;
 
     //If using the vector, there's no meaningful name to assign.
+    CBLAS_TRANSPOSE_t lt = Dot_trans(form1), rt = Dot_trans(form2);
     if (d1->names && uselm){
         if (lt == CblasTrans) apop_name_stack(out->names, d1->names, 'r', 'c');
         else                  apop_name_stack(out->names, d1->names, 'r');
@@ -462,8 +617,58 @@ APOP_VAR_ENDHEAD
         if (rt == CblasTrans) apop_name_stack(out->names, d2->names, 'c', 'r');
         else                  apop_name_stack(out->names, d2->names, 'c');
     }
-
-done:
-    Unset_gsl_handler
     return out;
 }
+
+/** Like \ref apop_dot, but write the product into an \ref apop_data set you have already
+allocated, optionally adding it to what is already there:
+\f$C \leftarrow \alpha\, d1\cdot d2 + \beta C\f$.
+
+Nothing is allocated, so in a loop that takes the same shape of product many times, you
+can allocate the output once and reuse it:
+
+\code
+apop_data *xpx = apop_data_alloc(k, k);
+for (int i=0; i< reps; i++){
+    ...
+    apop_dot_into(x, x, xpx, .form1='t');
+    ...
+}
+apop_data_free(xpx);
+\endcode
+
+\param d1, d2, form1, form2 As per \ref apop_dot, including which of the matrix and vector are used.
+\param out Where the product goes. If the product is a matrix, \c out->matrix must already
+have the right dimensions; if it is a vector (or a scalar, when both inputs are vectors),
+\c out->vector must be the right size (one element for a scalar). Its names are not touched.
+(No default, must not be \c NULL)
+\param alpha A scaling factor for the product. (default: 1)
+\param beta If nonzero, add the scaled product to \f$\beta\f$ times the existing contents
+of the output. If zero, the existing contents are overwritten, so they needn't be
+initialized. (default: 0)
+
+\return 0 on success; on failure, \c 'd' for a dimension mismatch, including an output of
+the wrong size, or \c 'm' for a GSL math error. The same code is put in \c out->error.
+
+\li The output may not share memory with either input.
+\li Because \c alpha defaults to one, you can't request \f$\alpha=0\f$; to just scale \c out, use <tt>gsl_matrix_scale</tt>.
+\li This function uses the \ref designated syntax for inputs.
+*/
+APOP_VAR_HEAD int apop_dot_into(const apop_data *d1, const apop_data *d2, apop_data *out, char form1, char form2, double alpha, double beta){
+    const apop_data * apop_varad_var(d1, NULL)
+    const apop_data * apop_varad_var(d2, NULL)
+    apop_data * apop_varad_var(out, NULL)
+    Apop_stopif(!d1 || !d2, if (out) out->error='d'; return 'd', 0, "Input data is NULL.");
+    Apop_stopif(!out, return 'd', 0, "The output data set is NULL.");
+    char apop_varad_var(form1, 0)
+    char apop_varad_var(form2, 0)
+    double apop_varad_var(alpha, 1)
+    double apop_varad_var(beta, 0)
+APOP_VAR_ENDHEAD
+    int uselm = dot_uses_matrix(d1, form1, "left");
+    int userm = dot_uses_matrix(d2, form2, "right");
+    if (uselm < 0 || userm < 0) return (out->error = 'd');
+    char err = dot_base(d1, d2, uselm, userm, form1, form2, alpha, beta, out, 'n');
+    if (err) out->error = err;
+    return err;
+}
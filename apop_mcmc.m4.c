@@ -41,6 +41,9 @@ Apop_settings_init(apop_mcmc,
    Apop_varad_set(start_at, '1');
    Apop_varad_set(base_step_fn, step_to_vector);
    Apop_varad_set(base_adapt_fn, sigma_adapt);
+   Apop_varad_set(thin, 1);
+   Apop_varad_set(batch_size, 1e4);
+   Apop_varad_set(output_type, out->output_pipe && !out->output_name ? 'p' : 'f');
    //all else defaults to zero/NULL
 )
 
@@ -138,6 +141,28 @@ static void one_step(apop_data *d, gsl_vector *draw, apop_model *m, apop_mcmc_se
 }
 
 
+/* One sweep through all the blocks, leaving the next step of the chain in out. If record
+   is set, the step is also appended to the data set of the chain's PMF. Not thread-safe:
+   the caller either owns the chain or holds a lock on it. */
+static int metro_sweep(double *out, gsl_rng *rng, apop_mcmc_settings *s, bool record){
+    apop_model *m = s->base_model;
+    gsl_vector_view vv = gsl_vector_view_array(out, s->block_starts[s->block_count]);
+    apop_data_pack(m->parameters, &(vv.vector));
+    apop_data *earlier_draws = record ? s->pmf->data : NULL;
+
+    int block = 0, done = 0, constraint_fails = 0;
+    while (!done){
+        s->proposal_count++;
+        if (record) earlier_draws->matrix = apop_matrix_realloc(earlier_draws->matrix, earlier_draws->matrix->size1+1, earlier_draws->matrix->size2);
+        one_step(m->data, &(vv.vector), m, s, rng, &constraint_fails, 
+                            earlier_draws, block, record ? earlier_draws->matrix->size1-1 : -1);
+        block = (block+1) % s->block_count;
+        done = !block; //have looped back to the start.
+        s->proposals[block].adapt_fn(s->proposals+block, s);
+    }
+    return constraint_fails;
+}
+
 /** The draw method for models estimated via \ref apop_model_metropolis.
 
 That method produces an \ref apop_pmf, typically with a few thousand draws from the
@@ -170,42 +195,113 @@ int apop_model_metropolis_draw(double *out, gsl_rng* rng, apop_model *model){
         apop_model_metropolis(model->data, rng, model);
         s = apop_settings_get_group(model, apop_mcmc);
     }
-    int constraint_fails = 0;
-OMP_critical (metro_draw)
-{
-    apop_model *m = s->base_model;
-    gsl_vector_view vv = gsl_vector_view_array(out, s->block_starts[s->block_count]);
-    apop_data_pack(m->parameters, &(vv.vector));
-    apop_data *earlier_draws = s->pmf->data;
-
-    int block = 0, done = 0;
-    while (!done){
-        s->proposal_count++;
-        earlier_draws->matrix = apop_matrix_realloc(earlier_draws->matrix, earlier_draws->matrix->size1+1, earlier_draws->matrix->size2);
-        one_step(s->base_model->data, &(vv.vector), m, s, rng, &constraint_fails, 
-                            earlier_draws, block, earlier_draws->matrix->size1-1);
-        block = (block+1) % s->block_count;
-        done = !block; //have looped back to the start.
-        s->proposals[block].adapt_fn(s->proposals+block, s);
-    }
+    int constraint_fails;
+    OMP_critical (metro_draw)
+    constraint_fails = metro_sweep(out, rng, s, true);
 
     Apop_stopif(constraint_fails, , 2, "%i proposals failed to meet your model's parameter constraints", constraint_fails);
-}
     return !!constraint_fails;
 }
 
 
-void main_mcmc_loop(apop_data *d, apop_model *m, apop_data *out, gsl_vector *draw, 
+/* The store for the recorded part of the chain. The draws we keep in memory are a ring
+   buffer holding the last keep_draws steps; if the user asked for streaming, recorded
+   draws are also queued in a batch and written out when the batch fills. Running
+   moments cover every recorded draw, whether or not it is still in memory. */
+typedef struct {
+    apop_data *kept, *batch;
+    size_t keep, batch_ct;
+    long int recorded;
+    gsl_vector *mean, *m2;
+    char append;
+} chain_store;
+
+static int is_streaming(apop_mcmc_settings *s){ return s->output_name || s->output_pipe; }
+
+static void flush_batch(chain_store *cs, apop_mcmc_settings *s){
+    if (!cs->batch_ct) return;
+    gsl_matrix *m = Apop_subm(cs->batch->matrix, 0, 0, cs->batch_ct, cs->batch->matrix->size2);
+    if (s->output_type == 'b'){
+        FILE *f = s->output_pipe ? s->output_pipe : fopen(s->output_name, cs->append=='a' ? "ab" : "wb");
+        Apop_stopif(!f, cs->batch_ct=0; return, 0, "Trouble opening %s for writing MCMC draws.", s->output_name);
+        for (size_t i=0; i< m->size1; i++) //rows of a full-width submatrix are contiguous, but be safe.
+            fwrite(gsl_matrix_ptr(m, i, 0), sizeof(double), m->size2, f);
+        if (s->output_pipe) fflush(f);
+        else                fclose(f);
+    } else if (s->output_type == 'd'){
+        //A savepoint, not begin/commit, so a transaction the caller already has open isn't
+        //nested or committed early.
+        apop_query("savepoint apop_mcmc_batch;");
+        apop_matrix_print(m, .output_name=s->output_name, .output_type='d', .output_append=cs->append);
+        apop_query("release savepoint apop_mcmc_batch;");
+    } else
+        apop_matrix_print(m, .output_name=s->output_name, .output_pipe=s->output_pipe,
+                             .output_type=s->output_type, .output_append=cs->append);
+    cs->append = 'a';
+    cs->batch_ct = 0;
+}
+
+static void record_draw(chain_store *cs, gsl_vector *draw, apop_mcmc_settings *s){
+    gsl_vector_memcpy(Apop_rv(cs->kept, cs->recorded % cs->keep), draw);
+    cs->recorded++;
+    //Welford's running mean and sum of squared deviations.
+    for (size_t i=0; i< draw->size; i++){
+        double x = draw->data[i], delta = x - cs->mean->data[i];
+        cs->mean->data[i] += delta/cs->recorded;
+        cs->m2->data[i] += delta*(x - cs->mean->data[i]);
+    }
+    if (!cs->batch) return;
+    gsl_vector_memcpy(Apop_rv(cs->batch, cs->batch_ct++), draw);
+    if (cs->batch_ct == cs->batch->matrix->size1) flush_batch(cs, s);
+}
+
+//Put the ring buffer in chronological order, trimmed to the number of draws made.
+static void finish_store(chain_store *cs){
+    if (!cs->recorded){
+        gsl_matrix_free(cs->kept->matrix);
+        cs->kept->matrix = NULL;
+        return;
+    }
+    if (cs->recorded < cs->keep){
+        cs->kept->matrix = apop_matrix_realloc(cs->kept->matrix, cs->recorded, cs->kept->matrix->size2);
+        return;
+    }
+    size_t start = cs->recorded % cs->keep;
+    if (!start) return;
+    gsl_matrix *ordered = gsl_matrix_alloc(cs->keep, cs->kept->matrix->size2);
+    for (size_t i=0; i< cs->keep; i++)
+        gsl_vector_memcpy(Apop_mrv(ordered, i), Apop_rv(cs->kept, (start+i) % cs->keep));
+    gsl_matrix_free(cs->kept->matrix);
+    cs->kept->matrix = ordered;
+}
+
+static apop_data *chain_moments(chain_store *cs){
+    apop_data *out = apop_data_alloc(0, 2, cs->mean->size);
+    gsl_vector_memcpy(Apop_rv(out, 0), cs->mean);
+    gsl_vector_memcpy(Apop_rv(out, 1), cs->m2);
+    gsl_vector_scale(Apop_rv(out, 1), cs->recorded > 1 ? 1./(cs->recorded-1) : GSL_NAN);
+    if (!cs->recorded) gsl_vector_set_all(Apop_rv(out, 0), GSL_NAN);
+    apop_name_add(out->names, "mean", 'r');
+    apop_name_add(out->names, "variance", 'r');
+    return out;
+}
+
+static void main_mcmc_loop(apop_data *d, apop_model *m, chain_store *cs, gsl_vector *draw, 
                         apop_mcmc_settings *s, gsl_rng *rng, int *constraint_fails){
     s->accept_count = 0;
     int block = 0;
+    long int burn_ct = s->periods*s->burnin;
     for (s->proposal_count=1; s->proposal_count< s->periods+1; s->proposal_count++){
-        one_step(d, draw, m, s, rng, constraint_fails, out, block
-                               , s->proposal_count-1 - s->periods*s->burnin);
+        one_step(d, draw, m, s, rng, constraint_fails, NULL, block, -1);
+        long int post_burn = s->proposal_count-1 - burn_ct;
+        if (post_burn >= 0 && !(post_burn % s->thin))
+            record_draw(cs, draw, s);
         block = (block+1) % s->block_count;
         s->proposals[block].adapt_fn(s->proposals+block, s);
         //if (constraint_fails>10000) break;
     }
+    if (cs->batch) flush_batch(cs, s);
+    finish_store(cs);
 }
 
 /** Use <a href="https://en.wikipedia.org/wiki/Metropolis-Hastings">Metropolis-Hastings
@@ -275,6 +371,20 @@ this is between 20% and 50%. Set <tt>apop_opts.verbose=3</tt> to see the stream
 of proposal points, their likelihoods, and the acceptance odds. You may want to
 set <tt>apop_opts.log_file=fopen("yourlog", "w")</tt> first.
 
+  \li For long chains, you may not want every draw held in memory. Set the \c thin
+element of the \ref apop_mcmc_settings group to record only every <em>n</em>th step. Set
+\c output_name (and, as desired, \c output_type) to stream the recorded draws to a text
+file, a binary file of raw <tt>double</tt>s, or a database table as the chain runs; draws
+are written in batches of \c batch_size. When streaming, only the last \c keep_draws
+draws (default: one batch) are kept in the output \ref apop_pmf.
+\code
+Apop_settings_add_group(your_model, apop_mcmc, .periods=1e8, .thin=100,
+                        .output_name="chain", .output_type='d');
+\endcode
+  \li Whether or not the draws are kept in memory, the output model's \c info element
+includes the count of draws recorded and a <tt>"<Chain moments>"</tt> page, giving the
+mean and variance of each parameter across all recorded draws.
+
 \li This function uses the \ref designated syntax for inputs.
 */
 APOP_VAR_HEAD apop_model *apop_model_metropolis(apop_data *d, gsl_rng *rng, apop_model *m){
@@ -284,8 +394,6 @@ APOP_VAR_HEAD apop_model *apop_model_metropolis(apop_data *d, gsl_rng *rng, apop
     gsl_rng *apop_varad_var(rng, apop_rng_get_thread(-1));
 APOP_VAR_END_HEAD
     apop_model *outp;
-    OMP_critical(metropolis)
-    {
     apop_mcmc_settings *s = apop_settings_get_group(m, apop_mcmc);
     if (!s)
         s = Apop_model_add_group(m, apop_mcmc);
@@ -296,7 +404,15 @@ APOP_VAR_END_HEAD
                 1, "Burn-in should be a fraction of the number of periods, "
                    "not a whole number of periods. Rescaling to burnin=%g."
                    , s->burnin/(s->periods+0.0));
-    apop_data *out = apop_data_alloc(s->periods*(1-s->burnin), drawv->size);
+    Apop_stopif(s->thin < 1, s->thin = 1, 1, "thin should be at least one. Setting thin=1.");
+    long int burn_ct = s->periods*s->burnin,
+             record_ct = (s->periods - burn_ct + s->thin - 1)/s->thin;
+    chain_store cs = {.append='w', .mean=gsl_vector_calloc(drawv->size), .m2=gsl_vector_calloc(drawv->size)};
+    cs.keep = s->keep_draws ? s->keep_draws 
+                            : is_streaming(s) ? s->batch_size : record_ct;
+    cs.keep = GSL_MAX(GSL_MIN(cs.keep, record_ct), 1);
+    if (is_streaming(s)) cs.batch = apop_data_alloc(GSL_MAX(s->batch_size, 1), drawv->size);
+    apop_data *out = cs.kept = apop_data_alloc(cs.keep, drawv->size);
 
     if (!s->proposals){
         set_block_count_and_block_starts(m->parameters, s, drawv->size);
@@ -317,20 +433,108 @@ APOP_VAR_END_HEAD
     if (s->start_at == '1') gsl_vector_set_all(drawv, 1);
     int constraint_fails = 0;
 
-    main_mcmc_loop(d, m, out, drawv, s, rng, &constraint_fails);
+    main_mcmc_loop(d, m, &cs, drawv, s, rng, &constraint_fails);
 
     Apop_notify(2, "M-H sampling accept percent = %3.3f%%", 100*(0.0+s->accept_count)/s->periods);
     Apop_stopif(constraint_fails, out->error='c', 2, "%i proposals failed to meet your model's parameter constraints", constraint_fails);
 
-    out->weights = gsl_vector_alloc(s->periods*(1-s->burnin));
-    gsl_vector_set_all(out->weights, 1);
+    Apop_stopif(!cs.recorded, out->error='n', 0, "No draws were recorded: with %li periods, "
+            "burn-in of %li, and thinning of every %i, there is nothing to keep. Returning "
+            "an empty PMF.", s->periods, burn_ct, s->thin);
+    if (cs.recorded){
+        out->weights = gsl_vector_alloc(out->matrix->size1);
+        gsl_vector_set_all(out->weights, 1);
+    }
     outp = apop_estimate(out, apop_pmf);
+    if (!cs.recorded) outp->error = 'n';
+    if (!outp->info) outp->info = apop_data_alloc();
+    apop_data_add_named_elmt(outp->info, "draws recorded", cs.recorded);
+    apop_data_add_page(outp->info, chain_moments(&cs), "<Chain moments>");
     s->pmf = outp;
     s->base_model = m;
     outp->draw = apop_model_metropolis_draw;
     apop_settings_copy_group(outp, m, "apop_mcmc");
 
     gsl_vector_free(drawv);
-    }
+    gsl_vector_free(cs.mean);
+    gsl_vector_free(cs.m2);
+    apop_data_free(cs.batch);
     return outp;
 }
+
+
+/* For apop_draw on a multivariate model with no draw method. Each thread gets its own
+   Markov chain, burned in on that thread's first draw. The swap model behind each chain
+   writes to its base model's parameters on every evaluation, so each chain evaluates
+   against its own copy of the base model, and parallel draws share nothing. Threads
+   numbered past chain_ct share one extra chain, under a lock. A copy of the model starts
+   with no chains. */
+typedef struct {
+    apop_model **chains;
+    int chain_ct;
+} apop_draw_chains_settings;
+
+Apop_settings_init(apop_draw_chains,
+    Apop_varad_set(chain_ct, 1);
+    out->chains = calloc(out->chain_ct+1, sizeof(apop_model*));
+)
+
+Apop_settings_copy(apop_draw_chains,
+    out->chains = calloc(out->chain_ct+1, sizeof(apop_model*));
+)
+
+Apop_settings_free(apop_draw_chains,
+    for (int i=0; i<= in->chain_ct; i++){
+        if (!in->chains[i]) continue;
+        apop_model *base = in->chains[i]->more;
+        apop_model_free(in->chains[i]);
+        apop_model_free(base);
+    }
+    free(in->chains);
+)
+
+//Generate a model with data/params reversed, and burn in a chain on it.
+extern apop_model *apop_swap_model; //apop_missing_data.c
+
+static apop_model *new_chain(apop_model *m, gsl_rng *r){
+    apop_model *base = apop_model_copy(m); //this chain's private copy; see above.
+    Apop_settings_rm_group(base, apop_draw_chains);
+    apop_model *swapped = apop_model_copy(apop_swap_model);
+    swapped->more = base;
+    swapped->msize1 = 1;
+    swapped->msize2 = m->dsize;
+    swapped->data = base->parameters;
+    Apop_settings_add_group(swapped, apop_mcmc, .burnin=0.999, .periods=1000);
+    apop_model *est = apop_model_metropolis(base->parameters, r, swapped);
+    apop_data_free(est->data);
+    apop_model_free(est);
+    Apop_settings_set(swapped, apop_mcmc, pmf, NULL); //we won't record the steps from here on.
+    return swapped;
+}
+
+static int chain_draw(double *out, gsl_rng *r, apop_model *m){
+    apop_draw_chains_settings *dc = Apop_settings_get_group(m, apop_draw_chains);
+    int constraint_fails, t = omp_threadnum;
+    if (t < dc->chain_ct){
+        if (!dc->chains[t]) dc->chains[t] = new_chain(m, r);
+        constraint_fails = metro_sweep(out, r, Apop_settings_get_group(dc->chains[t], apop_mcmc), false);
+    } else
+        OMP_critical (chain_draw)
+        {
+        t = dc->chain_ct;
+        if (!dc->chains[t]) dc->chains[t] = new_chain(m, r);
+        constraint_fails = metro_sweep(out, r, Apop_settings_get_group(dc->chains[t], apop_mcmc), false);
+        }
+    Apop_stopif(constraint_fails, , 2, "%i proposals failed to meet your model's parameter constraints", constraint_fails);
+    return !!constraint_fails;
+}
+
+/* Used by apop_draw, which makes sure this runs once per model, under a lock. After this,
+   m->draw is set and draws no longer pass through any global critical section. The
+   pointer is published only after the settings group is in place, and apop_draw reads it
+   atomically, so a thread that sees chain_draw also sees its chains. */
+void apop_mcmc_draw_setup(apop_model *m){
+    Apop_settings_add_group(m, apop_draw_chains, .chain_ct=omp_maxthreads);
+    OMP_atomic_write
+    m->draw = &chain_draw;
+}
@@ -3,6 +3,7 @@
 #include "apop_internal.h"
 #include <setjmp.h>
 #include <signal.h>
+#include <sys/time.h>
 #include <gsl/gsl_deriv.h>
 #include <gsl/gsl_siman.h>
 #include <gsl/gsl_randist.h>
@@ -30,10 +31,17 @@ typedef struct {
     char        want_cov, want_predicted, want_tests, want_info;
     jmp_buf     bad_eval_jump;
     apop_data** path;
+    struct ll_memo *memo;
+    apop_data   *trace;
+    gsl_vector  *trace_last;
+    size_t      trace_rows, f_evals, g_evals;
+    struct timeval start_time;
 }   infostruct;
 /** \endcond */ //End of Doxygen ignore.
 
 static apop_model * find_roots (infostruct p); //see end of file.
+static apop_data *hessian_base(apop_data *data, apop_model *model, double delta, infostruct *counts);
+static apop_data *covariance_base(apop_data *data, apop_model *model, double delta, infostruct *counts);
 
 m4_define(<|default_delta|>,1e-3) //as a macro, we can put it in documentation
 
@@ -58,6 +66,15 @@ Apop_settings_init(apop_mle,
     Apop_varad_set(step_size, 0.05);
     Apop_varad_set(delta, default_delta);
     Apop_varad_set(dim_cycle_tolerance, 0);
+    Apop_varad_set(lbfgs_memory, 10);
+    Apop_varad_set(batch_size, 1000);
+    Apop_varad_set(learning_decay, 0);
+    Apop_varad_set(sgd_window, 50);
+    Apop_varad_set(sgd_patience, 3);
+    Apop_varad_set(ll_cache, 0);
+    Apop_varad_set(stochastic, 'n');
+    Apop_varad_set(trace, 'n');
+    Apop_varad_set(threaded, 'n');
 //siman:
     //siman also uses step_size  = 1.;  
     Apop_varad_set(n_tries, 5);  //The number of points to try for each step. 
@@ -67,6 +84,7 @@ Apop_settings_init(apop_mle,
     Apop_varad_set(mu_t, 1.002); 
     Apop_varad_set(t_min, 5.0e-1);
     Apop_varad_set(rng, NULL);
+    Apop_varad_set(replicas, 8);
 )
 
 //      MLE support functions
@@ -74,36 +92,105 @@ Apop_settings_init(apop_mle,
 //negate the likelihood fns without bothering the user.
 
 static void apop_annealing(infostruct*); //below.
+static void apop_tempering(infostruct*);
+
+/* If the parameters are a single vector or a single matrix (no weights, no further pages
+   but informational ones), then rather than copying beta in, point the parameters' storage
+   at beta for the length of one evaluation. Returns the original data pointer, to be put
+   back via params_restore, or NULL if beta was unpacked in the usual way. 
+
+   While aliased, anything written to the parameters (e.g., by a constraint) goes to beta. */
+static double *params_alias(const gsl_vector *beta, apop_data *p){
+    int one_page = beta->stride == 1 && !p->weights;
+    for (apop_data *m = p->more; one_page && m; m = m->more)
+        one_page = m->names && m->names->title && m->names->title[0] == '<';
+    if (one_page && p->vector && !p->matrix 
+            && p->vector->stride == 1 && p->vector->size == beta->size){
+        double *was = p->vector->data;
+        p->vector->data = beta->data;
+        return was;
+    }
+    if (one_page && p->matrix && !p->vector 
+            && p->matrix->tda == p->matrix->size2 && p->matrix->size1*p->matrix->size2 == beta->size){
+        double *was = p->matrix->data;
+        p->matrix->data = beta->data;
+        return was;
+    }
+    apop_data_unpack(beta, p);
+    return NULL;
+}
+
+static void params_restore(apop_data *p, double *was){
+    if (!was) return;
+    if (p->vector) p->vector->data = was;
+    else           p->matrix->data = was;
+}
 
 static double one_d(double b, void *in){
     infostruct *i  = in;
     long double penalty = 0;
+    i->f_evals++;
     gsl_vector_set(i->gp->beta, i->gp->dimension, b);
+    if (!i->model->constraint){
+        double *was = params_alias(i->gp->beta, i->model->parameters);
+        double out = (*(i->f))(i->data, i->model);
+        params_restore(i->model->parameters, was);
+        return out;
+    }
     apop_data_unpack(i->gp->beta, i->model->parameters);
-	if (i->model->constraint)
-		penalty	= i->model->constraint(i->data, i->model);
+    penalty	= i->model->constraint(i->data, i->model);
 	return (*(i->f))(i->data, i->model) + penalty;
 }
 
 //Numeric first and second derivatives.
 
+/* Can the log likelihood be evaluated on several copies of this model at once? Only if
+   the user asked for it, since we can't see what state a log likelihood keeps. Even then,
+   a model whose more pointer it doesn't own, or a transformation holding another model in
+   its settings, shares that other model among all copies, so it gets one thread. */
+static int threadable(apop_model *m){
+    apop_mle_settings *mp = apop_settings_get_group(m, apop_mle);
+    if (!mp || mp->threaded != 'y') return 0;
+    if (m->more && !m->more_size) return 0;
+    char *transforms[] = {"apop_fix_params", "apop_dconstrain", "apop_cross",
+                          "apop_mixture", "apop_composition", "apop_coordinate_transform"};
+    for (int i=0; i< sizeof(transforms)/sizeof(char*); i++)
+        if (apop_settings_get_grp(m, transforms[i], 'c')) return 0;
+    return 1;
+}
+
 /* For each element of the parameter set, jiggle it to find its
- gradient. Return a vector as long as the parameter list. */
+ gradient. Return a vector as long as the parameter list. 
+
+ If threaded, each thread jiggles its own copy of the model. Every element starts from the
+ unperturbed parameters, so the result is the same either way. The evaluations are added
+ to info->f_evals. */
 static void apop_internal_numerical_gradient(apop_fn_with_params ll, 
                             infostruct* info, gsl_vector *out, double delta){
-    double result, err;
     gsl_vector *beta = apop_data_pack(info->model->parameters);
-    infostruct i = *info;
-    i.f = &ll;
-    i.gp = &(grad_params){ .beta = gsl_vector_alloc(beta->size)};
-    gsl_function F = { .function= one_d, 
-                       .params	= &i };
-	for (size_t j=0; j< beta->size; j++){
-		i.gp->dimension = j;
-		gsl_vector_memcpy(i.gp->beta, beta);
-		gsl_deriv_central(&F, gsl_vector_get(beta,j), delta, &result, &err);
-		gsl_vector_set(out, j, result);
-	}
+    int threaded = beta->size > 1 && !omp_inparallel && threadable(info->model);
+    OMP_parallel(if (threaded))
+    {
+        double result, err;
+        infostruct i = *info;
+        i.f = &ll;
+        i.f_evals = 0;
+        i.gp = &(grad_params){ .beta = gsl_vector_alloc(beta->size)};
+        if (threaded) i.model = apop_model_copy(info->model);
+        gsl_function F = { .function= one_d, 
+                           .params	= &i };
+        OMP_team_for (size_t j=0; j< beta->size; j++){
+            i.gp->dimension = j;
+            gsl_vector_memcpy(i.gp->beta, beta);
+            gsl_deriv_central(&F, gsl_vector_get(beta,j), delta, &result, &err);
+            gsl_vector_set(out, j, result);
+        }
+        gsl_vector_free(i.gp->beta);
+        if (threaded) apop_model_free(i.model);
+        OMP_atomic
+        info->f_evals += i.f_evals;
+    }
+    apop_data_unpack(beta, info->model->parameters);
     gsl_vector_free(beta);
 }
 
@@ -146,6 +233,7 @@ APOP_VAR_ENDHEAD
 typedef struct {
     apop_model *base_model;
     int *current_index;
+    size_t f_evals; //evaluations of the base model's log likelihood.
 } apop_model_for_infomatrix_struct;
 /** \endcond */
 
@@ -153,17 +241,22 @@ static long double apop_fn_for_infomatrix(apop_data *d, apop_model *m){
     static threadlocal gsl_vector *v = NULL;
     apop_model_for_infomatrix_struct *settings = m->more;
     apop_model *mm = settings->base_model;
-    apop_score_type ms = apop_score_vtable_get(mm);
-    if (ms){
+    if (apop_score_vtable_get(mm) || apop_dual_ll_vtable_get(mm)){
         Get_vmsizes(mm->parameters); //tsize
         if (!v || v->size != tsize){
             if (v) gsl_vector_free(v);
             v = gsl_vector_alloc(tsize);
         }
-        ms(d, v, mm);
+        apop_score(d, v, mm);
         return gsl_vector_get(v, *settings->current_index);
     } //else:
-        gsl_vector *vv = apop_numerical_gradient(d, mm);
+        Get_vmsizes(mm->parameters); //tsize
+        apop_mle_settings *mp = apop_settings_get_group(mm, apop_mle);
+        infostruct i = {.model = mm, .data = d};
+        gsl_vector *vv = gsl_vector_alloc(tsize);
+        apop_internal_numerical_gradient(mm->log_likelihood ? mm->log_likelihood : mm->p,
+                                         &i, vv, mp ? mp->delta : default_delta);
+        settings->f_evals += i.f_evals;
         double out = gsl_vector_get(vv, *settings->current_index);
         gsl_vector_free(vv);
         return out;
@@ -194,27 +287,54 @@ APOP_VAR_HEAD apop_data * apop_model_hessian(apop_data * data, apop_model *model
         delta = mp ? mp->delta : default_delta;
     }
 APOP_VAR_ENDHEAD
-    int k;
+    return hessian_base(data, model, delta, NULL);
+}
+
+/* The Hessian is built from numerical gradients of the score, so each of its evaluations
+   is a gradient evaluation, which may in turn take several log likelihood evaluations. If
+   counts is not NULL, add them to its f_evals and g_evals. */
+static apop_data *hessian_base(apop_data *data, apop_model *model, double delta, infostruct *counts){
     Get_vmsizes(model->parameters) //tsize
     size_t betasize  = tsize;
     apop_data *out = apop_data_calloc(0, betasize, betasize);
-    gsl_vector *dscore = gsl_vector_alloc(betasize);
-    apop_model_for_infomatrix_struct ms = { .base_model = model, .current_index = &k, };
-    apop_model *m = apop_model_copy(apop_model_for_infomatrix);
-    m->parameters = model->parameters;
-    m->more = &ms;
-    if (apop_settings_get_group(model, apop_mle))
-        apop_settings_copy_group(m, model, "apop_mle");
-    for (k=0; k< betasize; k++){
-        dscore = apop_numerical_gradient(data, m, delta);
-        //We get two estimates of the (k,j)th element, which are often very close,
-        //and take the mean.
-        for (size_t j=0; j< betasize; j++){
-            *gsl_matrix_ptr(out->matrix, k, j) += gsl_vector_get(dscore, j)/2;
-            *gsl_matrix_ptr(out->matrix, j, k) += gsl_vector_get(dscore, j)/2;
+    gsl_matrix *dscores = gsl_matrix_alloc(betasize, betasize);
+    //Row k is the gradient of the kth element of the score. If threaded, each
+    //thread works out its rows using its own copy of the model.
+    int threaded = betasize > 1 && !omp_inparallel && threadable(model);
+    OMP_parallel(if (threaded))
+    {
+        int k;
+        apop_model *base = threaded ? apop_model_copy(model) : model;
+        apop_model_for_infomatrix_struct ms = { .base_model = base, .current_index = &k, };
+        apop_model *m = apop_model_copy(apop_model_for_infomatrix);
+        m->parameters = base->parameters;
+        m->more = &ms;
+        if (apop_settings_get_group(model, apop_mle))
+            apop_settings_copy_group(m, model, "apop_mle");
+        infostruct i = {.model = m, .data = data};
+        OMP_team_for (size_t row=0; row< betasize; row++){
+            k = row;
+            apop_internal_numerical_gradient(m->log_likelihood, &i, Apop_mrv(dscores, row), delta);
+        }
+        m->parameters = NULL;
+        apop_model_free(m);
+        if (threaded) apop_model_free(base);
+        if (counts){
+            OMP_critical (hessian_counts)
+            {
+            counts->f_evals += ms.f_evals;
+            counts->g_evals += i.f_evals;
+            }
         }
-        gsl_vector_free(dscore);
     }
+    //We get two estimates of the (k,j)th element, which are often very close,
+    //and take the mean.
+    for (size_t k=0; k< betasize; k++)
+        for (size_t j=0; j< betasize; j++){
+            *gsl_matrix_ptr(out->matrix, k, j) += gsl_matrix_get(dscores, k, j)/2;
+            *gsl_matrix_ptr(out->matrix, j, k) += gsl_matrix_get(dscores, k, j)/2;
+        }
+    gsl_matrix_free(dscores);
     if (model->parameters->names->row){
         apop_name_stack(out->names, model->parameters->names, 'r');
         apop_name_stack(out->names, model->parameters->names, 'c', 'r');
@@ -246,7 +366,11 @@ APOP_VAR_HEAD apop_data * apop_model_numerical_covariance(apop_data * data, apop
         delta = mp ? mp->delta : default_delta;
     }
 APOP_VAR_ENDHEAD
-    apop_data *hessian = apop_model_hessian(data, model, delta);
+    return covariance_base(data, model, delta, NULL);
+}
+
+static apop_data *covariance_base(apop_data *data, apop_model *model, double delta, infostruct *counts){
+    apop_data *hessian = hessian_base(data, model, delta, counts);
     if (apop_opts.verbose > 1){
         printf("The estimated Hessian:\n");
         apop_data_show(hessian);
@@ -288,11 +412,65 @@ static void tracepath(const gsl_vector *beta, double value, apop_data **path){
 --Negate, because statisticians and social scientists like to maximize; physicists like to minimize.
 --Work out if the model provides log_likelihood or p.
 --Call \ref trace_path if needed.
---Go from a single vector to a full apop_data set and back (via apop_data_pack/unpack)
+--Go from a single vector to a full apop_data set and back (via apop_data_pack/unpack,
+  or by pointing the parameters at the vector; see params_alias)
 --Check the derivative function if available.
 --Check constraints.
 */
 
+/* A small exact-match cache of log likelihoods, keyed on the parameter vector, to save
+   re-evaluating at points the optimizer has already tried (e.g., f then fdf at the same
+   point). It is a ring of the last few evaluations, for one data set, so SGD's minibatches
+   never hit it. If the user says the log likelihood is stochastic, it is not set up at all. */
+typedef struct ll_memo {
+    gsl_matrix *keys;
+    double *values;
+    size_t filled, next, hits, lookups;
+    apop_data *data;
+} ll_memo;
+
+static ll_memo *memo_alloc(apop_mle_settings *mp, size_t beta_size, apop_data *d){
+    if (mp->ll_cache <= 0 || mp->stochastic == 'y') return NULL;
+    ll_memo *out = malloc(sizeof(ll_memo));
+    *out = (ll_memo){.keys=gsl_matrix_alloc(mp->ll_cache, beta_size), 
+                     .values=malloc(sizeof(double)*mp->ll_cache), .data=d};
+    return out;
+}
+
+static void memo_free(ll_memo *m, apop_mle_settings *mp, apop_model *est){
+    if (!m) return;
+    if (mp->verbose)
+        printf("Log likelihood cache: %zu hits in %zu lookups (%.1f%%).\n", 
+                m->hits, m->lookups, m->lookups ? 100.*m->hits/m->lookups : 0.);
+    if (est->info){
+        apop_data_add_named_elmt(est->info, "log likelihood cache hits", m->hits);
+        apop_data_add_named_elmt(est->info, "log likelihood cache lookups", m->lookups);
+    }
+    gsl_matrix_free(m->keys);
+    free(m->values);
+    free(m);
+}
+
+static int memo_get(ll_memo *m, apop_data *d, const gsl_vector *beta, double *out){
+    if (!m || d != m->data || beta->stride != 1) return 0;
+    m->lookups++;
+    for (size_t j=0; j< m->filled; j++)
+        if (!memcmp(Apop_mrv(m->keys, j)->data, beta->data, sizeof(double)*beta->size)){
+            m->hits++;
+            *out = m->values[j];
+            return 1;
+        }
+    return 0;
+}
+
+static void memo_put(ll_memo *m, apop_data *d, const gsl_vector *beta, double val){
+    if (!m || d != m->data || beta->stride != 1) return;
+    gsl_vector_memcpy(Apop_mrv(m->keys, m->next), beta);
+    m->values[m->next] = val;
+    m->next = (m->next+1) % m->keys->size1;
+    m->filled = GSL_MIN(m->filled+1, m->keys->size1);
+}
+
 static double negshell (const gsl_vector *beta, void * in){
     infostruct *i = in;
     double penalty = 0,
@@ -301,12 +479,19 @@ static double negshell (const gsl_vector *beta, void * in){
     f = i->model->log_likelihood? i->model->log_likelihood : i->model->p;
     Apop_stopif(!f, longjmp(i->bad_eval_jump, -1),
                 0, "The model you sent to the MLE function has neither log_likelihood element nor p element.");
-    apop_data_unpack(beta, i->model->parameters);
-	if (i->use_constraint && i->model->constraint)
-		penalty	= i->model->constraint(i->data, i->model);
-    if (penalty) apop_data_pack(i->model->parameters, (gsl_vector*) beta);
-    double f_val = f(i->data, i->model);
+    double *was = params_alias(beta, i->model->parameters);
+    double f_val;
+    if (!memo_get(i->memo, i->data, beta, &f_val)){
+        i->f_evals++;
+        if (i->use_constraint && i->model->constraint)
+            penalty	= i->model->constraint(i->data, i->model);
+        if (penalty && !was) apop_data_pack(i->model->parameters, (gsl_vector*) beta);
+        f_val = f(i->data, i->model);
+        //A constraint may have moved beta, so only unconstrained evaluations are cached.
+        if (!penalty && !gsl_isnan(f_val)) memo_put(i->memo, i->data, beta, f_val);
+    }
     out = penalty - f_val; //negative llikelihood
+    if (gsl_isnan(out)) params_restore(i->model->parameters, was);
     Apop_stopif(gsl_isnan(out), longjmp(i->bad_eval_jump, -1),
                 0, "I got a NaN in evaluating the objective function.%s", 
                     !i->model->constraint ? " Maybe add a constraint to your model?" : "");
@@ -326,6 +511,7 @@ static double negshell (const gsl_vector *beta, void * in){
         }
         i->best_ll = GSL_MAX(i->best_ll, this_ll);
     }
+    params_restore(i->model->parameters, was);
     return out;
 }
 
@@ -342,14 +528,18 @@ Finally, reverse the sign, since the GSL is trying to minimize instead of maximi
 */
     infostruct *i = in;
     apop_mle_settings *mp =  apop_settings_get_group(i->model, apop_mle);
-    apop_data_unpack(beta, i->model->parameters);
+    i->g_evals++;
     /* In all cases, negshell gets called first, so the constraint is already
        checked and beta nudged accordingly.
     if(i->model->constraint && i->model->constraint(i->data, i->model))
             apop_data_pack(i->model->parameters, (gsl_vector *) beta); */
     apop_score_type ms = apop_score_vtable_get(i->model);
-    if (ms) ms(i->data, g, i->model);
-    else {
+    if (ms || apop_dual_ll_vtable_get(i->model)) {
+        double *was = params_alias(beta, i->model->parameters);
+        apop_score(i->data, g, i->model);
+        params_restore(i->model->parameters, was);
+    } else { //the numerical gradient jiggles the parameters, so they get their own copy.
+        apop_data_unpack(beta, i->model->parameters);
         apop_fn_with_params ll = i->model->log_likelihood ? i->model->log_likelihood : i->model->p;
         apop_internal_numerical_gradient(ll, i, g, mp->delta);
     }
@@ -392,6 +582,61 @@ void add_info_criteria(apop_data *d, apop_model *m, apop_model *est, double ll,
     }
 }
 
+/* Record one iteration of the search, if the user asked for a trace: a row of the
+   <Trace> page, a call to trace_fn, or both. neg_ll is negshell's value at x, and g (if
+   any) its gradient. The step is the distance moved since the last recorded iteration. */
+static void trace_iteration(infostruct *i, int iter, const gsl_vector *x, double neg_ll, const gsl_vector *g){
+    apop_mle_settings *mp = apop_settings_get_group(i->model, apop_mle);
+    if (mp->trace != 'y' && !mp->trace_fn) return;
+    size_t n = x->size;
+    if (!i->trace){
+        i->trace = apop_data_alloc(mp->trace == 'y' ? 16 : 1, 7+n);
+        char *cols[] = {"iteration", "log likelihood", "gradient norm", "step size", 
+                        "f evaluations", "gradient evaluations", "seconds"};
+        for (int j=0; j< 7; j++) apop_name_add(i->trace->names, cols[j], 'c');
+        if (i->model->parameters->names->rowct == n)
+            for (size_t j=0; j< n; j++)
+                apop_name_add(i->trace->names, i->model->parameters->names->row[j], 'c');
+        i->trace_last = gsl_vector_alloc(n);
+        gsl_vector_set_all(i->trace_last, GSL_NAN); //so the first step size is NaN.
+    }
+    size_t row = mp->trace == 'y' ? i->trace_rows++ : 0;
+    if (row == i->trace->matrix->size1)
+        i->trace->matrix = apop_matrix_realloc(i->trace->matrix, 2*row, 7+n);
+    gsl_vector_sub(i->trace_last, x);
+    double step = gsl_blas_dnrm2(i->trace_last);
+    gsl_vector_memcpy(i->trace_last, x);
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    gsl_vector *r = Apop_rv(i->trace, row);
+    r->data[0] = iter;
+    r->data[1] = gsl_isnan(neg_ll) ? GSL_NAN : i->model->log_likelihood ? -neg_ll : log(-neg_ll);
+    r->data[2] = g ? gsl_blas_dnrm2(g) : GSL_NAN;
+    r->data[3] = step;
+    r->data[4] = i->f_evals;
+    r->data[5] = i->g_evals;
+    r->data[6] = (now.tv_sec - i->start_time.tv_sec) + (now.tv_usec - i->start_time.tv_usec)/1e6;
+    gsl_vector_memcpy(Apop_subvector(r, 7, n), x);
+    if (mp->trace_fn) mp->trace_fn(Apop_r(i->trace, row), mp->trace_param);
+}
+
+//Trim the trace to size and hang it on the info page, or just throw it out.
+static void trace_finish(infostruct *i, apop_model *est){
+    if (!i->trace) return;
+    apop_mle_settings *mp = apop_settings_get_group(i->model, apop_mle);
+    if (mp->trace == 'y'){
+        if (i->trace_rows)
+            i->trace->matrix = apop_matrix_realloc(i->trace->matrix, i->trace_rows, i->trace->matrix->size2);
+        else { //no iterations: just the column names.
+            gsl_matrix_free(i->trace->matrix);
+            i->trace->matrix = NULL;
+        }
+        apop_data_add_page(est->info, i->trace, "<Trace>");
+    } else apop_data_free(i->trace);
+    gsl_vector_free(i->trace_last);
+    i->trace = NULL;
+}
+
 static void auxinfo(apop_data *params, infostruct *i, int status, double ll){
     apop_model *est = i->model; //just an alias.
     /* This catches too many near-misses
@@ -399,13 +644,16 @@ static void auxinfo(apop_data *params, infostruct *i, int status, double ll){
         apop_assert(!est->constraint(i->data, est), "the maximum likelihood search ended "
                                             "at a point that doesn't satisfy the model's constraints.");*/
     if (i->want_cov=='y' && est->parameters){
-        apop_model_numerical_covariance(i->data, est, Apop_settings_get(est,apop_mle,delta));
+        covariance_base(i->data, est, Apop_settings_get(est,apop_mle,delta), i);
         if (i->want_tests=='y')
             apop_estimate_parameter_tests (est);
     }
     if (!est->info) est->info = apop_data_alloc();
     apop_data_add_named_elmt(est->info, "status", status);
+    apop_data_add_named_elmt(est->info, "log likelihood evaluations", i->f_evals);
+    apop_data_add_named_elmt(est->info, "gradient evaluations", i->g_evals);
     if (i->want_info=='y') add_info_criteria(i->data, i->model, est, ll, i->beta->size);
+    trace_finish(i, est);
 }
 
 static void apop_maximum_likelihood_w_d(apop_data * data, infostruct *i){
@@ -455,6 +703,7 @@ Inside the infostruct, you'll find these elements:
         status 	= gsl_multimin_fdfminimizer_iterate(s);
         if(status && status!=GSL_CONTINUE) break; //commented out error msg because too many GSL_ENOPROG false positives.
         //Apop_stopif(status && status!=GSL_CONTINUE, break, 0, "GSL error: %s", gsl_strerror(status));
+        trace_iteration(i, iter, s->x, s->f, s->gradient);
         status = gsl_multimin_test_gradient(s->gradient,  mp->tolerance);
         if(status && status!=GSL_CONTINUE) break; //commented out error msg because too many GSL_ENOPROG false positives.
         //Apop_stopif(status && status!=GSL_CONTINUE, break, 0, "GSL error: %s", gsl_strerror(status));
@@ -467,10 +716,254 @@ Inside the infostruct, you'll find these elements:
 	//Clean up, copy results to output estimate.
     apop_data_unpack(s->x, est->parameters);
 	gsl_multimin_fdfminimizer_free(s);
-    gsl_vector_free(i->beta);
     auxinfo(est->parameters, i, apopstatus, i->best_ll);
 }
 
+/* Limited-memory BFGS, with optional box bounds. Only the last lbfgs_memory steps and
+   changes in gradient are kept, so the state is O(memory x parameters), not O(parameters^2).
+
+   Bounds are handled by projection: every trial point is clipped to the box, parameters
+   pinned at a bound with the gradient pushing outward are held fixed for the step, and the
+   line search backtracks along the projected path. */
+static void lbfgs_project(gsl_vector *x, apop_mle_settings *mp){
+    for (size_t j=0; j< x->size; j++){
+        if (mp->lower_bound && x->data[j] < mp->lower_bound[j]) x->data[j] = mp->lower_bound[j];
+        if (mp->upper_bound && x->data[j] > mp->upper_bound[j]) x->data[j] = mp->upper_bound[j];
+    }
+}
+
+static int lbfgs_pinned(gsl_vector const *x, gsl_vector const *g, size_t j, apop_mle_settings *mp){
+    return (mp->lower_bound && x->data[j] <= mp->lower_bound[j] && g->data[j] > 0)
+        || (mp->upper_bound && x->data[j] >= mp->upper_bound[j] && g->data[j] < 0);
+}
+
+static double lbfgs_free_gradient_norm(gsl_vector const *x, gsl_vector const *g, apop_mle_settings *mp){
+    double sum = 0;
+    for (size_t j=0; j< x->size; j++)
+        if (!lbfgs_pinned(x, g, j, mp)) sum += gsl_pow_2(g->data[j]);
+    return sqrt(sum);
+}
+
+static void apop_lbfgs(apop_data *data, infostruct *i){
+    apop_model *est = i->model;
+    apop_mle_settings *mp = apop_settings_get_group(est, apop_mle);
+    size_t n = i->beta->size,
+           m = mp->lbfgs_memory > 0 ? mp->lbfgs_memory : 10;
+    int iter = 0, apopstatus = 0, stored = 0, newest = -1;
+    double f, fnew, rho[m], alpha[m];
+    gsl_matrix *S = gsl_matrix_alloc(m, n), *Y = gsl_matrix_alloc(m, n);
+    gsl_vector *x = i->beta, *g = gsl_vector_alloc(n), *d = gsl_vector_alloc(n),
+               *xnew = gsl_vector_alloc(n), *gnew = gsl_vector_alloc(n);
+    ctrl_c = 0;
+    lbfgs_project(x, mp);
+    if (setjmp(i->bad_eval_jump))
+        Apop_stopif(1, est->error='n'; goto done, 0, "Failure evaluating likelihood at the "
+                "starting point. Add a starting point? Setting est->error='n'.");
+    f = negshell(x, i);
+    dnegshell(x, i, g);
+    signal(SIGINT, mle_sigint);
+    do {
+        iter++;
+        if (setjmp(i->bad_eval_jump)) {
+            apopstatus = -1;
+            break;
+        }
+        double gnorm = lbfgs_free_gradient_norm(x, g, mp);
+        if (gnorm < mp->tolerance){
+            Apop_notify(2, "Optimum found.");
+            break;
+        }
+
+        //Two-loop recursion: d = -Hg, where H is built from the stored (s, y) pairs.
+        gsl_vector_memcpy(d, g);
+        for (size_t j=0; j< n; j++) if (lbfgs_pinned(x, g, j, mp)) d->data[j] = 0;
+        for (int k=0; k< stored; k++){
+            int idx = (newest - k + m) % m;
+            gsl_blas_ddot(Apop_mrv(S, idx), d, alpha+idx);
+            alpha[idx] *= rho[idx];
+            gsl_blas_daxpy(-alpha[idx], Apop_mrv(Y, idx), d);
+        }
+        double scale;
+        if (stored){
+            double yy;
+            gsl_blas_ddot(Apop_mrv(Y, newest), Apop_mrv(Y, newest), &yy);
+            scale = 1/(rho[newest]*yy);
+        } else scale = mp->step_size/gnorm;
+        gsl_vector_scale(d, scale);
+        for (int k=stored-1; k>= 0; k--){
+            int idx = (newest - k + m) % m;
+            double b;
+            gsl_blas_ddot(Apop_mrv(Y, idx), d, &b);
+            gsl_blas_daxpy(alpha[idx] - rho[idx]*b, Apop_mrv(S, idx), d);
+        }
+        gsl_vector_scale(d, -1);
+        for (size_t j=0; j< n; j++) if (lbfgs_pinned(x, g, j, mp)) d->data[j] = 0;
+
+        double gd;
+        gsl_blas_ddot(g, d, &gd);
+        if (gd >= 0){ //not a descent direction; forget the history and go downhill.
+            stored = 0;
+            for (size_t j=0; j< n; j++) 
+                d->data[j] = lbfgs_pinned(x, g, j, mp) ? 0 : -g->data[j]*mp->step_size/gnorm;
+        }
+
+        //Backtrack until the projected step gives sufficient decrease (Armijo).
+        int found = 0;
+        for (double t=1; !found && t > 1e-12; t/=2){
+            gsl_vector_memcpy(xnew, x);
+            gsl_blas_daxpy(t, d, xnew);
+            lbfgs_project(xnew, mp);
+            fnew = negshell(xnew, i);
+            gsl_vector_memcpy(gnew, xnew);
+            gsl_vector_sub(gnew, x);
+            double decrease;
+            gsl_blas_ddot(g, gnew, &decrease);
+            found = fnew <= f + 1e-4*decrease;
+        }
+        if (!found){ //No progress possible along this direction.
+            apopstatus = -1;
+            Apop_notify(1, "The line search found no decrease along the search direction; stopping.");
+            break;
+        }
+        dnegshell(xnew, i, gnew);
+
+        //Store s = xnew - x and y = gnew - g, if they keep H positive definite.
+        int next = (newest+1) % m;
+        gsl_vector *sv = Apop_mrv(S, next), *yv = Apop_mrv(Y, next);
+        gsl_vector_memcpy(sv, xnew);
+        gsl_vector_sub(sv, x);
+        gsl_vector_memcpy(yv, gnew);
+        gsl_vector_sub(yv, g);
+        double sy, yy;
+        gsl_blas_ddot(sv, yv, &sy);
+        gsl_blas_ddot(yv, yv, &yy);
+        if (sy > GSL_DBL_EPSILON * yy){
+            rho[next] = 1/sy;
+            newest = next;
+            stored = GSL_MIN(stored+1, m);
+        }
+        if (mp->verbose)
+            printf ("%5i f()=%10.5f |gradient|=%.3g\n", iter, fnew, gnorm);
+        gsl_vector_memcpy(x, xnew);
+        gsl_vector_memcpy(g, gnew);
+        f = fnew;
+        trace_iteration(i, iter, x, f, g);
+    } while (iter < mp->max_iterations && !ctrl_c);
+    signal(SIGINT, NULL);
+	Apop_stopif(iter==mp->max_iterations, apopstatus = -1, 1, "Max iterations reached, implying that I did not find an optimum.");
+    apop_data_unpack(x, est->parameters);
+    auxinfo(est->parameters, i, apopstatus, i->best_ll);
+    done:
+    gsl_matrix_free(S); gsl_matrix_free(Y);
+    gsl_vector_free(g); gsl_vector_free(d);
+    gsl_vector_free(xnew); gsl_vector_free(gnew);
+}
+
+/* Fill the preallocated batch with rows of data drawn at random, with replacement. */
+static void draw_minibatch(apop_data *data, apop_data *batch, size_t rows, gsl_rng *r){
+    size_t bsize = batch->matrix ? batch->matrix->size1 
+                 : batch->vector ? batch->vector->size : batch->textsize[0];
+    for (size_t k=0; k< bsize; k++){
+        size_t row = gsl_rng_uniform_int(r, rows);
+        if (data->vector)  batch->vector->data[k] = gsl_vector_get(data->vector, row);
+        if (data->weights) batch->weights->data[k] = gsl_vector_get(data->weights, row);
+        if (data->matrix)  gsl_vector_memcpy(Apop_mrv(batch->matrix, k), Apop_mrv(data->matrix, row));
+        for (size_t j=0; j< data->textsize[1]; j++)
+            apop_text_set(batch, k, j, "%s", data->text[row][j]);
+    }
+}
+
+/* Adam (Kingma and Ba): each step takes the gradient on a random minibatch of rows, and
+   moves along a running mean of gradients, scaled per dimension by a running mean of their
+   squares. Everything is per row, so step_size means the same thing at any batch size.
+
+   The stopping rule compares the mean per-row log likelihood over successive windows of
+   sgd_window steps; after sgd_patience windows in a row that improve by less than the
+   tolerance, we're done. */
+static void apop_sgd(apop_data *data, infostruct *i){
+    apop_model *est = i->model;
+    apop_mle_settings *mp = apop_settings_get_group(est, apop_mle);
+    Get_vmsizes(data); //maxsize
+    size_t n = i->beta->size,
+           bsize = GSL_MIN(mp->batch_size > 0 ? mp->batch_size : 1000, maxsize);
+    int iter = 0, apopstatus = 0, strikes = 0, window_ct = 0,
+        window = mp->sgd_window > 0 ? mp->sgd_window : 50;
+    double window_ll = 0, prior_window_ll = -GSL_POSINF;
+    const double b1 = 0.9, b2 = 0.999, eps = 1e-8;
+    char want_info = i->want_info;
+    apop_data *batch = NULL;
+    gsl_vector *x = i->beta, *g = NULL, *m1 = NULL, *m2 = NULL;
+    Apop_stopif(!est->log_likelihood, est->error='m'; goto done, 0, "The stochastic gradient "
+            "method works on a log likelihood that sums over rows, but this model has only a p function.");
+    Apop_stopif(!bsize, est->error='d'; goto done, 0, "No data rows to draw minibatches from.");
+    gsl_rng *r = mp->rng ? mp->rng : apop_rng_get_thread();
+    batch = apop_data_alloc(vsize ? bsize : 0, msize1 ? bsize : 0, msize2);
+    if (wsize) batch->weights = gsl_vector_alloc(bsize);
+    if (data->textsize[1]) apop_text_alloc(batch, bsize, data->textsize[1]);
+    if (data->names) {
+        apop_name_stack(batch->names, data->names, 'v');
+        apop_name_stack(batch->names, data->names, 'c');
+        apop_name_stack(batch->names, data->names, 't');
+    }
+    g = gsl_vector_alloc(n);
+    m1 = gsl_vector_calloc(n);
+    m2 = gsl_vector_calloc(n);
+    i->data = batch;
+    i->want_info = 'n'; //minibatch log likelihoods aren't comparable to the full-data optimum.
+    ctrl_c = 0;
+    lbfgs_project(x, mp);
+    signal(SIGINT, mle_sigint);
+    do {
+        iter++;
+        if (setjmp(i->bad_eval_jump)) {
+            apopstatus = -1;
+            break;
+        }
+        draw_minibatch(data, batch, maxsize, r);
+        double batch_f = negshell(x, i);
+        window_ll -= batch_f/bsize;
+        dnegshell(x, i, g);
+        double lr = mp->step_size / (1 + mp->learning_decay * (iter-1)),
+               c1 = 1 - pow(b1, iter), c2 = 1 - pow(b2, iter);
+        for (size_t j=0; j< n; j++){
+            double gj = g->data[j]/bsize;
+            m1->data[j] = b1*m1->data[j] + (1-b1)*gj;
+            m2->data[j] = b2*m2->data[j] + (1-b2)*gj*gj;
+            x->data[j] -= lr * (m1->data[j]/c1) / (sqrt(m2->data[j]/c2) + eps);
+        }
+        lbfgs_project(x, mp);
+        trace_iteration(i, iter, x, batch_f, g);
+        if (++window_ct < window) continue;
+        window_ll /= window;
+        if (mp->verbose)
+            printf ("%5i mean log likelihood per row over the last %i steps: %10.5g\n", iter, window, window_ll);
+        strikes = window_ll - prior_window_ll < mp->tolerance ? strikes+1 : 0;
+        if (strikes >= (mp->sgd_patience > 0 ? mp->sgd_patience : 3)){
+            Apop_notify(2, "Log likelihood stopped improving.");
+            break;
+        }
+        prior_window_ll = window_ll;
+        window_ll = window_ct = 0;
+    } while (iter < mp->max_iterations && !ctrl_c);
+    signal(SIGINT, NULL);
+	Apop_stopif(iter==mp->max_iterations, apopstatus = -1, 1, "Max iterations reached, implying that I did not find an optimum.");
+    i->data = data;
+    i->want_info = want_info;
+    if (want_info == 'y'){ //one full-data pass, for best_ll.
+        if (!setjmp(i->bad_eval_jump)) negshell(x, i);
+    }
+    apop_data_unpack(x, est->parameters);
+
+    done:
+    if (est->error){ //nothing was searched, so there's nothing to report but the status.
+        apopstatus = -1;
+        i->want_cov = i->want_tests = i->want_info = 'n';
+    }
+    auxinfo(est->parameters, i, apopstatus, i->best_ll);
+    apop_data_free(batch);
+    gsl_vector_free(g); gsl_vector_free(m1); gsl_vector_free(m2);
+}
+
 /* See apop_maximum_likelihood_w_d for notes. */
 static void apop_maximum_likelihood_no_d(apop_data * data, infostruct * i){
     apop_model *est = i->model;
@@ -489,7 +982,8 @@ static void apop_maximum_likelihood_no_d(apop_data * data, infostruct * i){
     gsl_vector_set_all (ss,  mp->step_size);
     gsl_multimin_function  minme = {.f = negshell, .n= betasize, .params = i};
     if (setjmp(i->bad_eval_jump))
-        Apop_stopif(1, return, 0, "Failure evaluating likelihood at the starting point. Add a starting point?");
+        Apop_stopif(1, gsl_multimin_fminimizer_free(s); gsl_vector_free(ss); return,
+                0, "Failure evaluating likelihood at the starting point. Add a starting point?");
     gsl_multimin_fminimizer_set (s, &minme, i->beta,  ss);
     //i->beta = s->x;
     signal(SIGINT, mle_sigint);
@@ -501,6 +995,7 @@ static void apop_maximum_likelihood_no_d(apop_data * data, infostruct * i){
         }
     status  = gsl_multimin_fminimizer_iterate(s);
     if (status)  break; 
+    trace_iteration(i, iter, s->x, s->fval, NULL);
     size = gsl_multimin_fminimizer_size(s);
     status  = gsl_multimin_test_size (size, mp->tolerance); 
     if(mp->verbose){
@@ -523,6 +1018,7 @@ static void apop_maximum_likelihood_no_d(apop_data * data, infostruct * i){
     if (status == GSL_SUCCESS) apopstatus = 0;
     apop_data_unpack(s->x, est->parameters);
 	gsl_multimin_fminimizer_free(s);
+    gsl_vector_free(ss);
     auxinfo(est->parameters, i, apopstatus, i->best_ll);
 }
 
@@ -590,13 +1086,139 @@ Onecheck(NM simplex)
 Onecheck(FR cg)
 Onecheck(BFGS cg)
 Onecheck(PR cg)
+Onecheck(L-BFGS)
+Onecheck(SGD)
 Onecheck(Annealing)
+Onecheck(Parallel tempering)
 Onecheck(Newton)
 Onecheck(Newton hybrid)
 Onecheck(Newton hybrid no scale)
 return 1;
 }
 
+/* Fill each row of starts with a starting point: a draw from the start model if there is
+   one, else a Latin hypercube sample from the box given by the bounds. */
+static void fill_starts(gsl_matrix *starts, apop_mle_settings *mp, gsl_rng *r){
+    size_t n = starts->size1, k = starts->size2;
+    if (mp->start_model){
+        for (size_t i=0; i< n; i++)
+            apop_draw(Apop_mrv(starts, i)->data, r, mp->start_model);
+        return;
+    }
+    size_t perm[n];
+    for (size_t j=0; j< k; j++){
+        double sp = mp->starting_pt ? mp->starting_pt[j] : 1,
+               width = 2*GSL_MAX(fabs(sp), 1),
+               lo = mp->lower_bound ? mp->lower_bound[j] : sp - width,
+               hi = mp->upper_bound ? mp->upper_bound[j] : sp + width;
+        for (size_t i=0; i< n; i++) perm[i] = i;
+        gsl_ran_shuffle(r, perm, n, sizeof(size_t));
+        for (size_t i=0; i< n; i++)
+            gsl_matrix_set(starts, i, j, lo + (perm[i] + gsl_rng_uniform(r))/n * (hi - lo));
+    }
+}
+
+/* Run one search from each of mp->starts starting points, in parallel if the model allows
+   it, and keep the one with the best log likelihood. The runs skip the covariance, tests,
+   and info criteria, which are calculated once, for the winner. The info page gets a
+   list of all the optima found. */
+static void multistart(apop_data *data, apop_model *dist, apop_mle_settings *mp){
+    size_t n = mp->starts;
+    Get_vmsizes(dist->parameters); //tsize
+    Apop_stopif(mp->start_model && mp->start_model->dsize != tsize, dist->error='s'; return,
+            0, "Draws from the start_model have size %i, but the model has %i parameters.", 
+            mp->start_model->dsize, tsize);
+    gsl_rng *r = mp->rng ? mp->rng : apop_rng_get_thread();
+    gsl_matrix *starts = gsl_matrix_alloc(n, tsize);
+    fill_starts(starts, mp, r);
+
+    apop_model *runs[n];
+    gsl_rng *rngs[n];
+    for (size_t i=0; i< n; i++){
+        runs[i] = apop_model_copy(dist);
+        apop_mle_settings *rmp = Apop_settings_get_group(runs[i], apop_mle);
+        rmp->starts = 1;
+        rmp->starting_pt = Apop_mrv(starts, i)->data;
+        rmp->path = NULL;
+        rmp->rng = rngs[i] = apop_rng_alloc(gsl_rng_get(r));
+        Apop_model_add_group(runs[i], apop_parts_wanted);
+    }
+    int threaded = !omp_inparallel && threadable(dist);
+    OMP_parallel(if (threaded))
+    OMP_team_for (size_t i=0; i< n; i++)
+        apop_maximum_likelihood(data, runs[i]);
+
+    //Put the runs in order of log likelihood, failed evaluations last.
+    double lls[n];
+    size_t order[n], best = 0;
+    for (size_t i=0; i< n; i++){
+        lls[i] = runs[i]->error ? GSL_NAN : get_ll(data, runs[i]);
+        if (gsl_isnan(lls[i])) lls[i] = GSL_NEGINF;
+        order[i] = i;
+    }
+    for (size_t i=1; i< n; i++)
+        for (size_t j=i; j> 0 && lls[order[j]] > lls[order[j-1]]; j--){
+            size_t tmp = order[j]; order[j] = order[j-1]; order[j-1] = tmp;
+        }
+    best = order[0];
+
+    //Move the best run's results to the input model.
+    gsl_vector *bestv = apop_data_pack(runs[best]->parameters);
+    apop_data_unpack(bestv, dist->parameters);
+    gsl_vector_free(bestv);
+    for (apop_data *page = runs[best]->parameters->more; page; page = page->more)
+        if (page->names->title && page->names->title[0] == '<'){
+            apop_data_rm_page(dist->parameters, page->names->title);
+            apop_data_add_page(dist->parameters, apop_data_copy(page), page->names->title);
+        }
+    apop_data_free(dist->info);
+    dist->info = runs[best]->info;
+    runs[best]->info = NULL;
+    if (!dist->info) dist->info = apop_data_alloc();
+
+    Apop_stopif(!isfinite(lls[best]), dist->error='n', 0, "None of the %zu searches found "
+            "a finite log likelihood. Returning the parameters of the first; the <Optima> "
+            "page of the info has the rest. Setting dist->error='n'.", n);
+    infostruct info = {.data = data, .model = dist};
+    get_desires(dist, &info);
+    if (!dist->error && info.want_cov=='y'){
+        apop_data_rm_page(dist->parameters, "<Covariance>"); //from some earlier estimation
+        apop_model_numerical_covariance(data, dist, mp->delta);
+        if (info.want_tests=='y') apop_estimate_parameter_tests(dist);
+    }
+    if (!dist->error && info.want_info=='y') add_info_criteria(data, dist, dist, lls[best], tsize);
+
+    //The list of optima, best first.
+    apop_data *optima = apop_data_alloc(n, tsize+2);
+    apop_name_add(optima->names, "log likelihood", 'c');
+    apop_name_add(optima->names, "status", 'c');
+    if (dist->parameters->names->rowct == tsize)
+        for (int j=0; j< tsize; j++)
+            apop_name_add(optima->names, dist->parameters->names->row[j], 'c');
+    int at_best = 0;
+    double worst = lls[best];
+    for (size_t i=0; i< n; i++){
+        apop_model *run = runs[order[i]];
+        gsl_matrix_set(optima->matrix, i, 0, lls[order[i]]);
+        gsl_matrix_set(optima->matrix, i, 1, run->info 
+                ? apop_data_get(run->info, .rowname="status") : GSL_NAN);
+        gsl_vector_view pv = gsl_matrix_subrow(optima->matrix, i, 2, tsize);
+        apop_data_pack(run->parameters, &pv.vector);
+        at_best += fabs(lls[order[i]] - lls[best]) <= mp->tolerance;
+        if (isfinite(lls[order[i]])) worst = lls[order[i]];
+    }
+    apop_data_add_named_elmt(dist->info, "starts", n);
+    apop_data_add_named_elmt(dist->info, "starts reaching the best optimum", at_best);
+    apop_data_add_named_elmt(dist->info, "log likelihood spread", lls[best] - worst);
+    apop_data_add_page(dist->info, optima, "<Optima>");
+
+    for (size_t i=0; i< n; i++){
+        apop_model_free(runs[i]);
+        gsl_rng_free(rngs[i]);
+    }
+    gsl_matrix_free(starts);
+}
+
 /** Find the likelihood-maximizing parameters of a model given data.
 
 \li I assume that \ref apop_prep has been called on your model. The easiest way to guarantee this is to use \ref apop_estimate, which calls this function if the input model has no \c estimate method.
@@ -631,32 +1253,47 @@ else
 \endcode
 
 \li During the search for an optimum, ctrl-C (SIGINT) will halt the search, and the function will return whatever parameters the search was on at the time.
+
+\li For a multimodal likelihood, set the \c starts element of the \ref apop_mle_settings
+group to run several searches from dispersed starting points and keep the best, e.g.,
+<tt>Apop_model_add_group(your_model, apop_mle, .starts=20, .lower_bound=(double[]){0, 0}, .upper_bound=(double[]){10, 5})</tt>.
 */
 void apop_maximum_likelihood(apop_data * data, apop_model *dist){
     apop_mle_settings *mp = apop_settings_get_group(dist, apop_mle);
     if (!mp) mp = Apop_model_add_group(dist, apop_mle);
-    apop_score_type ms = apop_score_vtable_get(dist);
+    int has_score = apop_score_vtable_get(dist) || apop_dual_ll_vtable_get(dist);
     Apop_stopif(check_method(mp->method), return, 0, "You set the method='%s', "
             "which is not on my list of allowable methods. See the apop_mle_settings "
             "documentation for the list of options", mp->method);
-    if (!mp->method || !strlen(mp->method)) mp->method = ms ? "FR cg" : "NM simplex";
+    if (!mp->method || !strlen(mp->method)) mp->method = has_score ? "FR cg" : "NM simplex";
 
     Apop_stopif(!dist->parameters, dist->error='p'; return, 0, "Not enough information to allocate parameters over which to optimize. If this was not called from apop_estimate, did you call apop_prep first?");
+    if (mp->starts > 1) {
+        multistart(data, dist, mp);
+        return;
+    }
     infostruct info = {.data           = data,
                        .use_constraint = 1,
                        .path           = mp->path,
                        .model          = dist};
     get_desires(dist, &info);
-    info.beta = apop_data_pack(dist->parameters);
-    if (setup_starting_point(mp, info.beta)) return;
+    info.beta = apop_data_pack(dist->parameters); //freed below; the methods only borrow it.
+    if (setup_starting_point(mp, info.beta)) {gsl_vector_free(info.beta); return;}
     info.model->data = data;
+    info.memo = memo_alloc(mp, info.beta->size, data);
+    gettimeofday(&info.start_time, NULL);
     if (mp->dim_cycle_tolerance)            dim_cycle(data, dist, info);
     else if (!strcasecmp(mp->method, "annealing"))   apop_annealing(&info);  //below.
+    else if (!strcasecmp(mp->method, "parallel tempering")) apop_tempering(&info);
     else if (!strcasecmp(mp->method, "NM simplex"))  apop_maximum_likelihood_no_d(data, &info);
+    else if (!strcasecmp(mp->method, "L-BFGS"))      apop_lbfgs(data, &info);
+    else if (!strcasecmp(mp->method, "SGD"))         apop_sgd(data, &info);
     else if (!strcasecmp(mp->method, "Newton") ||
             !strcasecmp(mp->method, "Newton hybrid")||
             !strcasecmp(mp->method, "Newton hybrid no scale")) find_roots (info);
     else   /* Conjugate Gradient*/   apop_maximum_likelihood_w_d(data, &info);
+    memo_free(info.memo, mp, dist);
+    gsl_vector_free(info.beta);
 }
 
 /** Maximum likelihod searches are not guaranteed to find a global optimum, and it can be
@@ -880,6 +1517,133 @@ done:
     auxinfo(i->model->parameters, i, apopstatus, i->best_ll);
 }
 
+/* Parallel tempering: a ladder of replicas, each a Metropolis walk at its own fixed
+   temperature, from t_min (coldest) geometrically up to t_initial (hottest). After each
+   replica takes iters_fixed_T steps, neighbors on the ladder propose to trade states, which
+   lets a cold replica escape a local optimum via a hotter one. The number of rounds is the
+   number of temperature drops the single annealing chain would take to cool from t_initial
+   to t_min at rate mu_t, so each replica does as much work as one annealing run.
+
+   Steps use annealing_step, scaled by sqrt(T/t_initial), so cold replicas take small steps.
+   Each replica has its own RNG, seeded in order from the main RNG. If the user set
+   threaded='y' and the model is threadable, each also gets its own copy of the model and
+   the sweeps run in parallel; else they run one after another. Either way, the result is
+   the same. */
+typedef struct {
+    infostruct info;
+    gsl_vector *proposal, *best;
+    gsl_rng *rng;
+    double t, step, energy, best_energy;
+} replica_s;
+
+//+inf for a point where the model can't be evaluated, so the walk never moves there.
+static double replica_energy(infostruct *i){
+    if (setjmp(i->bad_eval_jump)) return GSL_POSINF;
+    return negshell(i->beta, i);
+}
+
+static void replica_sweep(replica_s *rep, int steps, double k){
+    infostruct *i = &rep->info;
+    for (int s=0; s< steps; s++){
+        gsl_vector *current = i->beta;
+        gsl_vector_memcpy(rep->proposal, current);
+        i->beta = rep->proposal;
+        annealing_step(rep->rng, i, rep->step);
+        double e = replica_energy(i);
+        if (e <= rep->energy || gsl_rng_uniform(rep->rng) < exp(-(e - rep->energy)/(k*rep->t))){
+            rep->proposal = current;
+            rep->energy = e;
+            if (e < rep->best_energy){
+                rep->best_energy = e;
+                gsl_vector_memcpy(rep->best, i->beta);
+            }
+        } else i->beta = current;
+    }
+}
+
+static void apop_tempering(infostruct *i){
+    apop_model *ep = i->model;
+    apop_mle_settings *mp = apop_settings_get_group(ep, apop_mle);
+    Apop_stopif(mp->mu_t <= 1 || mp->t_min <= 0 || mp->t_initial <= mp->t_min, ep->error='s'; return,
+            0, "Parallel tempering needs 0 < t_min < t_initial and mu_t > 1.");
+    gsl_rng *r = mp->rng ? mp->rng : apop_rng_get_thread();
+    int rep_ct = GSL_MAX(mp->replicas, 2),
+        rounds = ceil(log(mp->t_initial/mp->t_min)/log(mp->mu_t)),
+        threaded = !omp_inparallel && threadable(ep),
+        swaps_tried = 0, swaps_made = 0, apopstatus = 0, round;
+    i->starting_pt    = apop_vector_map(i->beta, set_start);
+    i->use_constraint = 0; //negshell doesn't check it; annealing_step does.
+    annealing_check_constraint(i); //shift starting point if needed.
+
+    replica_s reps[rep_ct];
+    for (int k=0; k< rep_ct; k++){
+        replica_s *rep = reps+k;
+        *rep = (replica_s){.info = *i, .rng = apop_rng_alloc(gsl_rng_get(r)),
+                  .t = mp->t_min * pow(mp->t_initial/mp->t_min, k/(rep_ct-1.)),
+                  .proposal = gsl_vector_alloc(i->beta->size)};
+        rep->step = mp->step_size * sqrt(rep->t/mp->t_initial);
+        rep->info.beta = apop_vector_copy(i->beta);
+        rep->info.model = threaded ? apop_model_copy(ep) : ep;
+        rep->info.want_info = 'n';
+        rep->info.path = NULL;
+        rep->info.memo = NULL;
+        rep->info.trace = NULL;
+        rep->energy = rep->best_energy = replica_energy(&rep->info);
+        rep->best = apop_vector_copy(i->beta);
+    }
+    ctrl_c = 0;
+    signal(SIGINT, mle_sigint);
+    for (round=0; round< rounds && !ctrl_c; round++){
+        OMP_parallel(if (threaded))
+        {
+            OMP_team_for (int k=0; k< rep_ct; k++)
+                replica_sweep(reps+k, mp->iters_fixed_T, mp->k);
+        }
+        //Propose swaps between neighbors, alternating even and odd pairs by round.
+        for (int k=round%2; k+1< rep_ct; k+=2){
+            replica_s *lo = reps+k, *hi = reps+k+1;
+            double log_accept = (1/lo->t - 1/hi->t) * (lo->energy - hi->energy) / mp->k;
+            swaps_tried++;
+            if (log_accept >= 0 || gsl_rng_uniform(r) < exp(log_accept)){
+                gsl_vector *tmp = lo->info.beta;
+                lo->info.beta = hi->info.beta;
+                hi->info.beta = tmp;
+                double e = lo->energy;
+                lo->energy = hi->energy;
+                hi->energy = e;
+                swaps_made++;
+            }
+        }
+        int best = 0;
+        for (int k=1; k< rep_ct; k++) if (reps[k].best_energy < reps[best].best_energy) best = k;
+        trace_iteration(i, round+1, reps[best].best, reps[best].best_energy, NULL);
+        if (mp->verbose && !(round % 100))
+            printf("Round %i: best f()=%g, swap acceptance rate %g\n", round, 
+                        reps[best].best_energy, swaps_made/(swaps_tried+0.0));
+    }
+    signal(SIGINT, NULL);
+    int best = 0;
+    for (int k=1; k< rep_ct; k++) if (reps[k].best_energy < reps[best].best_energy) best = k;
+    Apop_stopif(!isfinite(reps[best].best_energy), apopstatus = -1, 0, 
+            "No replica found a point where the log likelihood could be evaluated.");
+    gsl_vector_memcpy(i->beta, reps[best].best);
+    for (int k=0; k< rep_ct; k++){
+        gsl_vector_free(reps[k].info.beta);
+        gsl_vector_free(reps[k].proposal);
+        gsl_vector_free(reps[k].best);
+        gsl_rng_free(reps[k].rng);
+        if (threaded) apop_model_free(reps[k].info.model);
+    }
+    if (!apopstatus && i->want_info == 'y'){ //sets best_ll
+        if (!setjmp(i->bad_eval_jump)) negshell(i->beta, i);
+    }
+    apop_data_unpack(i->beta, ep->parameters); 
+    auxinfo(ep->parameters, i, apopstatus, i->best_ll);
+    apop_data_add_named_elmt(ep->info, "replicas", rep_ct);
+    apop_data_add_named_elmt(ep->info, "swap acceptance rate", swaps_tried ? swaps_made/(swaps_tried+0.0) : GSL_NAN);
+    gsl_vector_free(i->starting_pt);
+}
+
 /* This function calls the various GSL root-finding algorithms to find the zero of the score.
    Cut/pasted/modified from the GSL documentation.  */
 static apop_model * find_roots (infostruct p) {
@@ -900,6 +1664,7 @@ static apop_model * find_roots (infostruct p) {
         iter++;
         if (setjmp(p.bad_eval_jump)) break;
         status = gsl_multiroot_fsolver_iterate (s);
+        trace_iteration(&p, iter, s->x, GSL_NAN, s->f); //root-finders don't evaluate the log likelihood.
         if (!mlep || mlep->verbose)
             printf ("iter = %3zu x = % .3f f(x) = % .3e\n", iter, gsl_vector_get (s->x, 0), gsl_vector_get (s->f, 0));
         if (status)   /* check if solver is stuck */
@@ -910,7 +1675,6 @@ static apop_model * find_roots (infostruct p) {
     Apop_notify(2, "status = %s\n", gsl_strerror(status));
     apop_data_unpack(s->x, dist->parameters);
     gsl_multiroot_fsolver_free (s);
-    gsl_vector_free (p.beta);
     auxinfo(dist->parameters, &p, apopstatus, 0); //root-finders don't store best val.
     return dist;
 }
@@ -279,7 +279,9 @@ apop_data_unpack to reformat to the preferred shape.
 \param m    The parametrized model, which must have either a \c log_likelihood or a \c p method.
 
 \li The default is to use \ref apop_numerical_gradient, but special-case calculations
-for certain models are held in a vtable; see \ref vtables for details. The typedef
+for certain models are held in a vtable; see \ref vtables for details. Failing that, if
+the model has a log likelihood written with dual numbers, I use that to find the exact
+gradient; see \ref dualsec. The typedef
 new functions must conform to and the hash used for lookups are:
 
 \code
@@ -295,6 +297,7 @@ void apop_score(apop_data *d, gsl_vector *out, apop_model *m){
         ms(d, out, m);
         return;
     }
+    if (!apop_dual_score(d, out, m)) return;
     gsl_vector * numeric_default = apop_numerical_gradient(d, m);
     gsl_vector_memcpy(out, numeric_default);
     gsl_vector_free(numeric_default);
@@ -394,9 +397,6 @@ apop_model *apop_parameter_model(apop_data *d, apop_model *m){
     }
 }
 
-extern apop_model *apop_swap_model; //apop_missing_data.c
-int apop_model_metropolis_draw(double *out, gsl_rng* rng, apop_model *params);//apop_update.c
-
 /** Draw from a model. 
 
 \param out An already-allocated array of <tt>double</tt>s to be filled by the draw method. It must have size <tt>m->dsize</tt>.
@@ -405,33 +405,35 @@ int apop_model_metropolis_draw(double *out, gsl_rng* rng, apop_model *params);//
 
 \li If the model has its own \c draw method, then this function will call it.
 \li Else, if the model is univariate, use \ref apop_arms_draw to generate random draws.
+Each thread refines its own copy of the envelope.
 \li Else, if the model is multivariate, use \ref apop_model_metropolis to generate random draws.
+Each thread gets its own Markov chain, burned in on that thread's first draw, so
+parallel calls (as in \ref apop_model_draws) do not wait on each other. The steps are
+not saved anywhere.
 \li This makes a single draw of the given size. See \ref apop_model_draws to fill a matrix with draws.
 
 \return Zero on success; nozero on failure. <tt>out[0]</tt> is probably \c NAN on failure.
 */
 int apop_draw(double *out, gsl_rng *r, apop_model *m){
     if (!r) r = apop_rng_get_thread(-1);
-    if (m->draw)
-        return m->draw(out, r, m); 
-    else if (m->dsize == 1)
-        return apop_arms_draw(out, r, m);
-    //Else, MCMC, possibly setting it up first.
-    //generate a model with data/params reversed
-    //estimate mcmc. Swapped model will be stored as settings->base_model.
+    int (*draw)(double *, gsl_rng *, apop_model *);
+    //Another thread may be setting up m->draw; see below.
+    OMP_atomic_read
+    draw = m->draw;
+    if (draw) return draw(out, r, m); 
+    /* Else, ARMS or MCMC. Set up once, then each thread draws using its own state. The
+       settings group is added before m->draw is published, by an atomic write, so any
+       thread that reads the new m->draw above also sees the group it uses. */
     OMP_critical (apop_draw)
-    if (!Apop_settings_get_group(m, apop_mcmc)){
-        apop_model *swapped = apop_model_copy(apop_swap_model);
-        swapped->more = m;
-        swapped->msize1 = 1;
-        swapped->msize2 = m->dsize;
-        swapped->data = m->parameters;
-        Apop_settings_add_group(swapped, apop_mcmc, .burnin=0.999, .periods=1000);
-        apop_model *est = apop_model_metropolis(m->parameters, r, swapped); //leak.
-        m->draw = apop_model_metropolis_draw;
-        apop_settings_copy_group(m, est, "apop_mcmc");
+    if (!m->draw){
+        if (m->dsize == 1){
+            if (!Apop_settings_get_group(m, apop_arms))
+                Apop_settings_add_group(m, apop_arms, .model=m);
+            OMP_atomic_write
+            m->draw = &apop_arms_draw;
+        } else apop_mcmc_draw_setup(m);
     }
-    return apop_draw(out, r, m);
+    return m->draw(out, r, m);
 }
 
 /** Allocate and initialize the \c parameters, \c info, and other requisite parts of a \ref apop_model.
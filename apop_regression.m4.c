@@ -2,7 +2,7 @@
 /* Copyright (c) 2006--2007 by Ben Klemens.  Licensed under the GPLv2; see COPYING.  */
 
 #include "apop_internal.h"
-#include <search.h> //lsearch; bsearch is in stdlib.
+#include <stdint.h>
 
 /* For use by MLE, OLS, et al. Available for public use, but undocumented. */
 void apop_estimate_parameter_tests (apop_model *est){
@@ -50,30 +50,141 @@ static int strcmpwrap(const void *a, const void *b){
     return strcmp(*aa, *bb);
 }
 
+/* Both unique-element functions insert into an open-addressing hash set (linear
+probing, doubled when half full), counting as they go; then they sort the distinct
+elements once. NaNs are all considered equal, and sort to the end; -0 and 0 are the
+same element. */
+
+typedef struct {double val, count;} dcount;
+typedef struct {char *str; double count;} tcount;
+
+static int compare_dcounts(const void *a, const void *b){
+    return compare_doubles(&((dcount const*)a)->val, &((dcount const*)b)->val); }
+
+static int compare_tcounts(const void *a, const void *b){
+    return strcmp(((tcount const*)a)->str, ((tcount const*)b)->str); }
+
+static size_t mix_hash(uint64_t x){ //The splitmix64 finalizer.
+    x ^= x >> 30; x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27; x *= 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+static size_t hash_double(double x){
+    if (x == 0) x = 0; //-0 == 0.
+    uint64_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    return mix_hash(bits);
+}
+
+static size_t hash_string(char const *s){ //FNV-1a
+    uint64_t h = 14695981039346656037ULL;
+    for ( ; *s; s++) h = (h ^ (unsigned char)*s) * 1099511628211ULL;
+    return mix_hash(h);
+}
+
+#define Empty_slot SIZE_MAX
+
+/* The hash set holds indices into the list of distinct items. Returns the new table,
+which may have been grown. */
+static size_t *hash_slots_grow(size_t *slots, size_t *slot_ct, size_t item_ct, size_t (*hash)(void const *, size_t), void const *items){
+    if (slots && 2*(item_ct+1) <= *slot_ct) return slots;
+    free(slots);
+    *slot_ct = *slot_ct ? *slot_ct*2 : 64;
+    slots = malloc(sizeof(size_t) * *slot_ct);
+    for (size_t i=0; i< *slot_ct; i++) slots[i] = Empty_slot;
+    for (size_t i=0; i< item_ct; i++){
+        size_t h = hash(items, i) & (*slot_ct-1);
+        while (slots[h] != Empty_slot) h = (h+1) & (*slot_ct-1);
+        slots[h] = i;
+    }
+    return slots;
+}
+
+static size_t rehash_dcount(void const *items, size_t i){ return hash_double(((dcount const*)items)[i].val); }
+static size_t rehash_tcount(void const *items, size_t i){ return hash_string(((tcount const*)items)[i].str); }
+
+//Returns the sorted list of distinct elements, with counts; sets *ct to the list length.
+static dcount *unique_doubles(gsl_vector const *v, size_t *ct){
+    size_t slot_ct = 0, *slots = NULL, item_ct = 0, nan_ct = 0, space = 16;
+    dcount *items = malloc(sizeof(dcount)*space);
+    for (size_t i=0; v && i< v->size; i++){
+        double val = gsl_vector_get(v, i);
+        if (gsl_isnan(val)) {nan_ct++; continue;}
+        slots = hash_slots_grow(slots, &slot_ct, item_ct, rehash_dcount, items);
+        size_t h = hash_double(val) & (slot_ct-1);
+        while (slots[h] != Empty_slot && items[slots[h]].val != val) h = (h+1) & (slot_ct-1);
+        if (slots[h] != Empty_slot) {items[slots[h]].count++; continue;}
+        if (item_ct+1 >= space) items = realloc(items, sizeof(dcount)*(space*=2));
+        items[item_ct] = (dcount){.val=val, .count=1};
+        slots[h] = item_ct++;
+    }
+    free(slots);
+    qsort(items, item_ct, sizeof(dcount), compare_dcounts);
+    if (nan_ct) items[item_ct++] = (dcount){.val=GSL_NAN, .count=nan_ct};
+    *ct = item_ct;
+    return items;
+}
+
+static tcount *unique_strings(apop_data const *d, size_t col, size_t *ct){
+    size_t slot_ct = 0, *slots = NULL, item_ct = 0, space = 16;
+    tcount *items = malloc(sizeof(tcount)*space);
+    for (size_t i=0; i< d->textsize[0]; i++){
+        char *val = d->text[i][col];
+        slots = hash_slots_grow(slots, &slot_ct, item_ct, rehash_tcount, items);
+        size_t h = hash_string(val) & (slot_ct-1);
+        while (slots[h] != Empty_slot && strcmp(items[slots[h]].str, val)) h = (h+1) & (slot_ct-1);
+        if (slots[h] != Empty_slot) {items[slots[h]].count++; continue;}
+        if (item_ct == space) items = realloc(items, sizeof(tcount)*(space*=2));
+        items[item_ct] = (tcount){.str=val, .count=1};
+        slots[h] = item_ct++;
+    }
+    free(slots);
+    qsort(items, item_ct, sizeof(tcount), compare_tcounts);
+    *ct = item_ct;
+    return items;
+}
+
 /** Give me a vector of numbers, and I'll give you a sorted list of the unique elements.
   This is basically running <tt>select distinct datacol from data order by datacol</tt>,
   but without the aid of the database.
 
   \param v a vector of items
-  \return a sorted vector of the distinct elements that appear in the input.
-  \li NaNs (if any) appear at the end of the sort order.
-  \see apop_text_unique_elements 
+  \return a sorted vector of the distinct elements that appear in the input; \c NULL if the input is empty.
+  \li NaNs (if any) appear once, at the end of the sort order.
+  \li This runs in time linear in the size of the input, plus the time to sort the distinct elements.
+  \see apop_text_unique_elements, apop_vector_unique_counts
 */
 gsl_vector * apop_vector_unique_elements(const gsl_vector *v){
-    size_t prior_elmt_ctr = 107;
-    size_t elmt_ctr = 0;
-    double *elmts = NULL;
-    for (size_t i=0; i< v->size; i++){
-        if (prior_elmt_ctr != elmt_ctr)
-            elmts = realloc(elmts, sizeof(double)*(elmt_ctr+1));
-        prior_elmt_ctr = elmt_ctr;
-        double val = gsl_vector_get(v, i);
-        lsearch(&val, elmts, &elmt_ctr, sizeof(double), compare_doubles);
-        if (prior_elmt_ctr < elmt_ctr)
-            qsort(elmts, elmt_ctr, sizeof(double), compare_doubles);
+    size_t ct;
+    dcount *items = unique_doubles(v, &ct);
+    gsl_vector *out = ct ? gsl_vector_alloc(ct) : NULL;
+    for (size_t i=0; i< ct; i++) gsl_vector_set(out, i, items[i].val);
+    free(items);
+    return out;
+}
+
+/** Like \ref apop_vector_unique_elements, but also gives the number of times each element appears.
+
+  \param v a vector of items
+  \return An \ref apop_data set whose \c vector is the sorted list of distinct elements,
+  and whose \c weights give the count of each. \c NULL if \c v is empty.
+  This is <tt>select datacol, count(*) from data group by datacol order by datacol</tt>.
+  \li NaNs (if any) are all counted together, in the last row.
+*/
+apop_data * apop_vector_unique_counts(const gsl_vector *v){
+    size_t ct;
+    dcount *items = unique_doubles(v, &ct);
+    apop_data *out = NULL;
+    if (ct){
+        out = apop_data_alloc(ct);
+        out->weights = gsl_vector_alloc(ct);
+        for (size_t i=0; i< ct; i++){
+            gsl_vector_set(out->vector, i, items[i].val);
+            gsl_vector_set(out->weights, i, items[i].count);
+        }
     }
-    gsl_vector *out = apop_array_to_vector(elmts, elmt_ctr);
-    free(elmts);
+    free(items);
     return out;
 }
 
@@ -84,31 +195,35 @@ gsl_vector * apop_vector_unique_elements(const gsl_vector *v){
   \param d An \ref apop_data set with a text component
   \param col The text column you want me to use.
   \return An \ref apop_data set with a single sorted column of text, where each unique text input appears once.
-  \see apop_vector_unique_elements
+  \li This runs in time linear in the size of the input, plus the time to sort the distinct elements.
+  \see apop_vector_unique_elements, apop_text_unique_counts
 */
 apop_data * apop_text_unique_elements(const apop_data *d, size_t col){
-  char   **tval;
-
-  //first element for free
-  size_t prior_elmt_ctr, elmt_ctr = 1;
-  char **telmts = malloc(sizeof(char**)*2);
-  telmts[0] = d->text[0][col];
-
-    for (int i=1; i< d->textsize[0]; i++){
-        prior_elmt_ctr  = elmt_ctr;
-        tval    =  &(d->text[i][col]);
-        lsearch (tval, telmts, &elmt_ctr, sizeof(char*), strcmpwrap);
-        if (prior_elmt_ctr  < elmt_ctr){
-            qsort(telmts, elmt_ctr, sizeof(char*), strcmpwrap);
-            telmts = realloc(telmts, sizeof(char**)*(elmt_ctr+1));
-        }
-    }
+    apop_data *out = apop_text_unique_counts(d, col);
+    if (out) {gsl_vector_free(out->weights); out->weights = NULL;}
+    return out;
+}
+
+/** Like \ref apop_text_unique_elements, but also gives the number of times each element appears.
 
-    //pack and ship
-    apop_data *out = apop_text_alloc(NULL, elmt_ctr, 1);
-    for (int j=0; j< elmt_ctr; j++)
-        apop_text_set(out, j, 0, telmts[j]);
-    free(telmts);
+  \param d An \ref apop_data set with a text component
+  \param col The text column you want me to use.
+  \return An \ref apop_data set with a single sorted column of text, where each unique
+  text input appears once, and whose \c weights give the count of each.
+*/
+apop_data * apop_text_unique_counts(const apop_data *d, size_t col){
+    Apop_stopif(!d, return NULL, 0, "You sent me a NULL data set. Returning NULL.");
+    Apop_stopif(d->textsize[0] && col >= d->textsize[1], return NULL, 0, "You asked for text column %zu, "
+            "but the data set has only %zu text columns. Returning NULL.", col, d->textsize[1]);
+    size_t ct;
+    tcount *items = unique_strings(d, col, &ct);
+    apop_data *out = apop_text_alloc(NULL, ct, 1);
+    if (ct) out->weights = gsl_vector_alloc(ct);
+    for (size_t j=0; j< ct; j++){
+        apop_text_set(out, j, 0, items[j].str);
+        gsl_vector_set(out->weights, j, items[j].count);
+    }
+    free(items);
     return out;
 }
 
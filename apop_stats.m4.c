@@ -4,20 +4,132 @@
 #include "apop_internal.h"
 #include <gsl/gsl_rng.h>
 #include <gsl/gsl_eigen.h>
+#include <ctype.h>
 
 #define Check_vw    \
     Apop_stopif(!v, return GSL_NAN, 0, "data vector is NULL. Returning NaN.\n");            \
     Apop_stopif(!v->size, return GSL_NAN, 0, "data vector has size 0. Returning NaN.\n");   \
     Apop_stopif(weights && weights->size != v->size, return GSL_NAN, 0, "data vector has size %zu; weighting vector has size %zu. Returning NaN.\n", v->size, weights->size);
 
+/* Summation kernels. 
+
+Sums use Neumaier's compensated summation, split over four independent lanes so that
+the additions don't wait on each other and the compiler can vectorize the contiguous
+case. The error is then independent of n, rather than growing with it.
+
+The moments are calculated a block at a time: find the block's mean, then take the sum
+of squared deviations from it while the block is still in cache, then merge the block
+into the running totals via the pairwise update of Chan, Golub, and LeVeque. This is
+one pass over the data, but never forms the catastrophically cancelling E(x^2)-E^2(x). */
+
+#define Neumaier(s, c, x) do {double t_ = (s) + (x);                            \
+        (c) += (fabs(s) >= fabs(x)) ? ((s) - t_) + (x) : ((x) - t_) + (s);       \
+        (s) = t_;} while (0)
+
+long double apop_compensated_sum(double const *x, size_t stride, size_t n){
+    double s[4] = {0}, c[4] = {0};
+    size_t i = 0;
+    if (stride == 1)
+        for ( ; i+4 <= n; i+=4)
+            for (int k=0; k< 4; k++) Neumaier(s[k], c[k], x[i+k]);
+    else
+        for ( ; i+4 <= n; i+=4)
+            for (int k=0; k< 4; k++) Neumaier(s[k], c[k], x[(i+k)*stride]);
+    for (int k=0; i < n; i++) Neumaier(s[k], c[k], x[i*stride]);
+    long double out = 0, comp = 0;
+    for (int k=0; k< 4; k++){
+        out  += s[k];
+        comp += c[k];
+    }
+    return out + comp;
+}
+
+#define Moment_block 256
+
+/* Weighted or unweighted (w==NULL) count, mean of x, and sum of cross-products of
+deviations from the means of x and y. If cm is NULL, skip the second pass over each
+block. When y is x, this takes exactly the steps of the one-variable version, so the
+covariance of a vector with itself is bit-for-bit its variance. */
+static void fused_comoments(double const *x, size_t xstride, double const *y, size_t ystride,
+                            double const *w, size_t wstride, size_t n,
+                            long double *wsum, long double *mean, long double *cm){
+    int same = (x == y && xstride == ystride);
+    long double W = 0, mux = 0, muy = 0, C = 0;
+    for (size_t b=0; b < n; b+=Moment_block){
+        size_t len = GSL_MIN(Moment_block, n-b);
+        double const *xb = x + b*xstride, *yb = y + b*ystride;
+        double const *wb = w ? w + b*wstride : NULL;
+        double bw = len, bsumx = 0, bsumy = 0;
+        if (!wb){
+            bsumx = apop_compensated_sum(xb, xstride, len);
+            bsumy = same ? bsumx : apop_compensated_sum(yb, ystride, len);
+        } else {
+            double wxs = 0, wys = 0;
+            bw = 0;
+            for (size_t i=0; i< len; i++){
+                bw  += wb[i*wstride];
+                wxs += wb[i*wstride] * xb[i*xstride];
+                if (!same) wys += wb[i*wstride] * yb[i*ystride];
+            }
+            bsumx = wxs;
+            bsumy = same ? wxs : wys;
+        }
+        if (!bw) continue;
+        double bmeanx = bsumx/bw, bmeany = bsumy/bw, bc = 0, corrx = 0, corry = 0;
+        if (cm){
+            if (same && !wb && xstride==1)
+                for (size_t i=0; i< len; i++){
+                    double d = xb[i] - bmeanx;
+                    bc    += d*d;
+                    corrx += d;
+                }
+            else if (same)
+                for (size_t i=0; i< len; i++){
+                    double d  = xb[i*xstride] - bmeanx;
+                    double wi = wb ? wb[i*wstride] : 1;
+                    bc    += wi*d*d;
+                    corrx += wi*d;
+                }
+            else
+                for (size_t i=0; i< len; i++){
+                    double dx = xb[i*xstride] - bmeanx,
+                           dy = yb[i*ystride] - bmeany;
+                    double wi = wb ? wb[i*wstride] : 1;
+                    bc    += wi*dx*dy;
+                    corrx += wi*dx;
+                    corry += wi*dy;
+                }
+            if (same) corry = corrx;
+            bc -= corrx*corry/bw; //the corrected two-pass step: remove rounding error in the block means.
+            bmeanx += corrx/bw;
+            bmeany += corry/bw;
+        }
+        long double deltax = bmeanx - mux, deltay = bmeany - muy, newW = W + bw;
+        mux += deltax * bw/newW;
+        muy += deltay * bw/newW;
+        C   += bc + deltax*deltay * W*bw/newW;
+        W    = newW;
+    }
+    if (wsum) *wsum = W;
+    if (mean) *mean = mux;
+    if (cm)   *cm   = C;
+}
+
+/* Weighted or unweighted (w==NULL) count, mean, and sum of squared deviations from the
+mean. If m2 is NULL, skip the second pass over each block. */
+void apop_fused_moments(double const *x, size_t xstride, double const *w, size_t wstride,
+                          size_t n, long double *wsum, long double *mean, long double *m2){
+    fused_comoments(x, xstride, x, xstride, w, wstride, n, wsum, mean, m2);
+}
+
 /** Returns the sum of the data in the given vector.
+
+\li The sum is compensated, so adding many elements of differing magnitude loses no
+more precision than adding a few.
 */
 long double apop_vector_sum(const gsl_vector *in){
     Apop_stopif(!in, return 0, 1, "You just asked me to sum a NULL. Returning zero.");
-    long double out = 0;
-    for (size_t i=0; i< in->size; i++)
-        out += gsl_vector_get(in, i);
-	return out; 
+	return apop_compensated_sum(in->data, in->stride, in->size);
 }
 
 /** \def apop_sum(in)
@@ -242,6 +354,161 @@ APOP_VAR_ENDHEAD
   Apop_stopif(1, return NAN, 1, "I couldn't find the metric type you gave, %c, in my list of supported types. Returning NaN", metric);
 }
 
+#define Dist_tile 256
+
+/* One tile of the distance matrix, rows [i0, i0+ni) of X against rows [j0, j0+nj) of Y.
+For the Gram-based metrics, the tile is XY' via BLAS, then adjusted elementwise. */
+static void distance_tile(gsl_matrix const *X, gsl_matrix const *Y, gsl_vector const *xnorm,
+                gsl_vector const *ynorm, size_t i0, size_t ni, size_t j0, size_t nj,
+                char metric, double bandwidth, gsl_matrix *out){
+    gsl_matrix_view o = gsl_matrix_submatrix(out, i0, j0, ni, nj);
+    if (metric == 'm'){
+        for (size_t i=0; i< ni; i++){
+            double const *x = gsl_matrix_const_ptr(X, i0+i, 0);
+            for (size_t j=0; j< nj; j++){
+                double const *y = gsl_matrix_const_ptr(Y, j0+j, 0);
+                double d = 0;
+                for (size_t k=0; k< X->size2; k++) d += fabs(x[k] - y[k]);
+                gsl_matrix_set(&o.matrix, i, j, d);
+            }
+        }
+        return;
+    }
+    gsl_matrix_const_view xs = gsl_matrix_const_submatrix(X, i0, 0, ni, X->size2);
+    gsl_matrix_const_view ys = gsl_matrix_const_submatrix(Y, j0, 0, nj, Y->size2);
+    gsl_blas_dgemm(CblasNoTrans, CblasTrans, 1, &xs.matrix, &ys.matrix, 0, &o.matrix);
+    for (size_t i=0; i< ni; i++){
+        double *row = gsl_matrix_ptr(&o.matrix, i, 0);
+        for (size_t j=0; j< nj; j++){
+            if (metric == 'c') {row[j] = 1 - row[j]; continue;}
+            //squared distance = |x|^2 + |y|^2 - 2x.y, which rounding can push below zero.
+            double sq = GSL_MAX(xnorm->data[(i0+i)*xnorm->stride] + ynorm->data[(j0+j)*ynorm->stride] - 2*row[j], 0);
+            row[j] = metric == 'g' ? exp(-sq/(2*bandwidth*bandwidth)) : sqrt(sq);
+        }
+    }
+}
+
+//For Mahalanobis: x -> L^{-1}x, where LL' = Sigma. Done on rows, that's X L^{-T}.
+static gsl_matrix *whiten(gsl_matrix const *X, gsl_matrix const *L){
+    gsl_matrix *out = apop_matrix_copy(X);
+    gsl_blas_dtrsm(CblasRight, CblasLower, CblasTrans, CblasNonUnit, 1, L, out);
+    return out;
+}
+
+static gsl_matrix *unit_rows(gsl_matrix const *X){
+    gsl_matrix *out = apop_matrix_copy(X);
+    for (size_t i=0; i< out->size1; i++){
+        gsl_vector_view r = gsl_matrix_row(out, i);
+        gsl_vector_scale(&r.vector, 1./gsl_blas_dnrm2(&r.vector));
+    }
+    return out;
+}
+
+/** Find the distance between every row of one data set and every row of another (or of the same set).
+
+\param a  The first data set; each row of the \c matrix is a point. (No default, must not be \c NULL)
+\param b  The second data set, with the same number of columns as \c a. If \c NULL, find the distances among the rows of \c a. (default = \c NULL)
+\param metric
+ - 'e' (the default): the Euclidean distance. Calculated via the Gram matrix: \f$\|x-y\|^2 = \|x\|^2 + \|y\|^2 - 2x\cdot y\f$, where the cross products come from BLAS.
+ - 'm': the Manhattan distance, \f$\sum_i |x_i - y_i|\f$.
+ - 'h': the Mahalanobis distance, \f$\sqrt{(x-y)'\Sigma^{-1}(x-y)}\f$, where \f$\Sigma\f$ is given by \c covariance.
+ - 'c': the cosine distance, \f$1 - x\cdot y/(\|x\|\|y\|)\f$. Rows of all zeros give NaN.
+ - 'g': the Gaussian kernel, \f$\exp(-\|x-y\|^2/(2\sigma^2))\f$, where \f$\sigma\f$ is \c bandwidth. This is a similarity, not a distance: one on the diagonal, falling toward zero.
+\param bandwidth The \f$\sigma\f$ of the Gaussian kernel. (default = 1)
+\param covariance For the Mahalanobis distance, the covariance matrix. It must be positive definite. (default: \ref apop_data_covariance of \c a)
+
+\return An \ref apop_data set whose \f$(i, j)\f$th element is the distance between
+row \f$i\f$ of \c a and row \f$j\f$ of \c b. The row names of \c a become the row
+names of the output, and the row names of \c b become the column names.
+\exception out->error='m' The covariance matrix isn't positive definite. The matrix is all NaNs.
+\exception out->error='d' The covariance matrix isn't \f$k\times k\f$, where \f$k\f$ is the number of columns of the data. The matrix is all NaNs.
+
+\li The matrix is calculated in tiles of 256 by 256, in parallel if OpenMP is
+available. When \c b is \c NULL, only the tiles on and above the diagonal are
+calculated, and the result is exactly symmetric, with an exact zero (or one, for
+the Gaussian kernel) diagonal.
+\li For other metrics, see \ref apop_vector_distance.
+\li This function uses the \ref designated syntax for inputs.
+*/
+APOP_VAR_HEAD apop_data *apop_data_distance_matrix(apop_data const *a, apop_data const *b, char metric, double bandwidth, apop_data const *covariance){
+    apop_data const * apop_varad_var(a, NULL);
+    Apop_stopif(!a || !a->matrix, return NULL, 0, "The first data set is NULL or has no matrix. Returning NULL.");
+    apop_data const * apop_varad_var(b, NULL);
+    Apop_stopif(b && !b->matrix, return NULL, 0, "The second data set has no matrix. Returning NULL.");
+    Apop_stopif(b && b->matrix->size2 != a->matrix->size2, return NULL, 0, "The first data set has "
+            "%zu columns and the second has %zu. Returning NULL.", a->matrix->size2, b->matrix->size2);
+    char apop_varad_var(metric, 'e');
+    double apop_varad_var(bandwidth, 1);
+    apop_data const * apop_varad_var(covariance, NULL);
+APOP_VAR_ENDHEAD
+    metric = tolower(metric);
+    Apop_stopif(!strchr("emhcg", metric), return NULL, 0, "I don't know the metric '%c'. Returning NULL.", metric);
+    int symmetric = !b || b->matrix == a->matrix;
+    gsl_matrix const *X = a->matrix, *Y = symmetric ? X : b->matrix;
+    apop_data *out = apop_data_alloc(X->size1, Y->size1);
+    gsl_matrix *wx = NULL, *wy = NULL;
+    gsl_vector *xnorm = NULL, *ynorm = NULL;
+    if (metric == 'h'){
+        size_t k = X->size2;
+        Apop_stopif(covariance && (!covariance->matrix || covariance->matrix->size1 != k
+                                   || covariance->matrix->size2 != k),
+                if (out->matrix) gsl_matrix_set_all(out->matrix, GSL_NAN); out->error='d'; return out, 0,
+                "The data has %zu columns, so the covariance must be %zu x %zu.", k, k, k);
+        apop_data *cov = covariance ? NULL : apop_data_covariance(a);
+        gsl_matrix *L = apop_matrix_copy(covariance ? covariance->matrix : cov->matrix);
+        apop_data_free(cov);
+        gsl_error_handler_t *prior_handler = gsl_set_error_handler_off();
+        int status = gsl_linalg_cholesky_decomp(L);
+        gsl_set_error_handler(prior_handler);
+        Apop_stopif(status, gsl_matrix_free(L); if (out->matrix) gsl_matrix_set_all(out->matrix, GSL_NAN);
+                out->error='m'; return out, 0, "The covariance matrix isn't positive definite.");
+        X = wx = whiten(X, L);
+        Y = symmetric ? X : (wy = whiten(Y, L));
+        gsl_matrix_free(L);
+    } else if (metric == 'c'){
+        X = wx = unit_rows(X);
+        Y = symmetric ? X : (wy = unit_rows(Y));
+    }
+    if (metric == 'e' || metric == 'h' || metric == 'g'){
+        xnorm = gsl_vector_alloc(X->size1);
+        for (size_t i=0; i< X->size1; i++){
+            gsl_vector_const_view r = gsl_matrix_const_row(X, i);
+            double n;
+            gsl_blas_ddot(&r.vector, &r.vector, &n);
+            gsl_vector_set(xnorm, i, n);
+        }
+        if (!symmetric){
+            ynorm = gsl_vector_alloc(Y->size1);
+            for (size_t i=0; i< Y->size1; i++){
+                gsl_vector_const_view r = gsl_matrix_const_row(Y, i);
+                double n;
+                gsl_blas_ddot(&r.vector, &r.vector, &n);
+                gsl_vector_set(ynorm, i, n);
+            }
+        }
+    }
+    size_t row_tiles = (X->size1 + Dist_tile-1)/Dist_tile, col_tiles = (Y->size1 + Dist_tile-1)/Dist_tile;
+    OMP_for (size_t t=0; t< row_tiles*col_tiles; t++){
+        size_t ti = t/col_tiles, tj = t%col_tiles;
+        if (symmetric && tj < ti) continue;
+        size_t i0 = ti*Dist_tile, j0 = tj*Dist_tile;
+        distance_tile(X, Y, xnorm, symmetric ? xnorm : ynorm, i0, GSL_MIN(Dist_tile, X->size1-i0),
+                j0, GSL_MIN(Dist_tile, Y->size1-j0), metric, bandwidth, out->matrix);
+    }
+    if (symmetric)
+        for (size_t i=0; i< X->size1; i++){
+            gsl_matrix_set(out->matrix, i, i, metric == 'g' ? 1 : 0);
+            for (size_t j=0; j< i; j++)
+                gsl_matrix_set(out->matrix, i, j, gsl_matrix_get(out->matrix, j, i));
+        }
+    if (a->names) apop_name_stack(out->names, a->names, 'r');
+    apop_data const *bn = symmetric ? a : b;
+    if (bn->names) apop_name_stack(out->names, bn->names, 'c', 'r');
+    gsl_matrix_free(wx); gsl_matrix_free(wy);
+    gsl_vector_free(xnorm); gsl_vector_free(ynorm);
+    return out;
+}
+
 /** This function will normalize a vector, either such that it has mean
 zero and variance one, or ranges between zero and one, or sums to one.
 
@@ -309,10 +576,10 @@ APOP_VAR_END_HEAD
 */
 long double apop_matrix_sum(const gsl_matrix *m){
     Apop_stopif(!m, return 0, 1, "You just asked me to sum a NULL. Returning zero.");
+    if (m->tda == m->size2) return apop_compensated_sum(m->data, 1, m->size1*m->size2);
     long double	sum	= 0;
 	for (size_t j=0; j< m->size1; j++)
-		for (size_t i=0; i< m->size2; i++)
-			sum += gsl_matrix_get(m, j, i);
+        sum += apop_compensated_sum(m->data + j*m->tda, 1, m->size2);
 	return sum;
 }
 
@@ -322,18 +589,8 @@ long double apop_matrix_sum(const gsl_matrix *m){
 \return The mean of all cells of the matrix.
 */
 double apop_matrix_mean(const gsl_matrix *data){
-    if (!data) return 0;
-    long double avg = 0;
-    int cnt = 0;
-    for(size_t i=0; i < data->size1; i++)
-        for(size_t j=0; j < data->size2; j++){
-            double x = gsl_matrix_get(data, i,j);
-            long double ratio = cnt/(cnt+1.0);
-            cnt++;
-            avg*= ratio;
-            avg+= x/cnt;
-        }
-	return avg;
+    if (!data || !data->size1 || !data->size2) return 0;
+	return apop_matrix_sum(data)/((long double)data->size1*data->size2);
 }
 
 /** Returns the mean and population variance of all elements of a matrix.
@@ -354,41 +611,100 @@ var *= (data->size1*data->size2)/(data->size1*data->size2-1.0);
 */
 void apop_matrix_mean_and_var(const gsl_matrix *data, double *mean, double *var){
     if (!data) {*mean=0; *var=GSL_NAN; return;}
-    long double avg     = 0,
-                avg2    = 0;
-    size_t cnt= 0;
-    long double x, ratio;
-    for(size_t i=0; i < data->size1; i++)
-        for(size_t j=0; j < data->size2; j++){
-            x     = gsl_matrix_get(data, i,j);
-            ratio = cnt/(cnt+1.0);
-            cnt   ++;
-            avg   *= ratio;
-            avg2  *= ratio;
-            avg   += x/(cnt +0.0);
-            avg2  += gsl_pow_2(x)/(cnt +0.0);
-        }
+    long double cnt = 0, avg = 0, m2 = 0;
+    for (size_t i=0; i < data->size1; i++){
+        long double rn, ravg, rm2;
+        apop_fused_moments(data->data + i*data->tda, 1, NULL, 0, data->size2, &rn, &ravg, &rm2);
+        if (!rn) continue;
+        long double delta = ravg - avg, newcnt = cnt + rn;
+        avg += delta * rn/newcnt;
+        m2  += rm2 + delta*delta * cnt*rn/newcnt;
+        cnt  = newcnt;
+    }
 	*mean = avg;
-    *var  = avg2 - gsl_pow_2(avg); //E[x^2] - E^2[x]
+    *var  = m2/cnt;
 }
 
-/** Put summary information about the columns of a table (mean, std dev, variance, min, median, max) in a table.
+static int cmp_doubles(void const *a, void const *b){
+    double x = *(double const *)a, y = *(double const *)b;
+    return (x > y) - (x < y);
+}
 
-\param indata The table to be summarized. An \ref apop_data structure. May have a <tt>weights</tt> element.
-\return     An \ref apop_data structure with one row for each column in the original
-            table, and a column for each summary statistic.
-\exception out->error='a'  Allocation error.
+static void swap_doubles(double *a, double *b){ double t = *a; *a = *b; *b = t; }
+
+/* Rearrange x[lo..hi] so that x[r] holds the element of rank r, for every r in the sorted
+list of ranks (all in [lo, hi]). Quickselect with a median-of-three pivot and a three-way
+partition, recursing only into the side(s) that hold a requested rank; past the depth
+limit, or for short spans, just sort the span. */
+static void multiselect(double *x, size_t lo, size_t hi, size_t const *ranks, size_t k, int depth){
+    while (k && hi > lo){
+        if (hi - lo < 16 || depth-- <= 0){
+            qsort(x+lo, hi-lo+1, sizeof(double), cmp_doubles);
+            return;
+        }
+        size_t mid = lo + (hi-lo)/2;
+        if (x[mid] < x[lo]) swap_doubles(x+mid, x+lo);
+        if (x[hi] < x[lo])  swap_doubles(x+hi, x+lo);
+        if (x[hi] < x[mid]) swap_doubles(x+hi, x+mid);
+        double pivot = x[mid];
+        //Afterward, [lo, lt) < pivot, [lt, gt) == pivot, and [gt, hi] > pivot.
+        size_t lt = lo, gt = hi+1, i = lo;
+        while (i < gt){
+            if (x[i] < pivot)      swap_doubles(x+lt++, x+i++);
+            else if (x[i] > pivot) swap_doubles(x+i, x+--gt);
+            else i++;
+        }
+        size_t left_ct = 0, right_start;
+        while (left_ct < k && ranks[left_ct] < lt) left_ct++;
+        for (right_start = left_ct; right_start < k && ranks[right_start] < gt; ) right_start++;
+        if (left_ct) multiselect(x, lo, lt-1, ranks, left_ct, depth);
+        ranks += right_start;
+        k -= right_start;
+        lo = gt;
+    }
+}
 
-\li This function gives more columns than you probably want; use \ref apop_data_prune_columns to pick the ones you want to see.
+/* Percentiles by selection, not by a full sort. The ith output is percentile pcts[i]
+of the n elements of x, under the rounding rules of apop_vector_percentiles; pcts must
+be ascending. Reorders x. */
+static void select_percentiles(double *x, size_t n, char rounding, int const *pcts, int ct, double *out){
+    size_t *ranks = malloc(sizeof(size_t)*2*ct), rank_ct = 0;
+    #define Add_rank(r) if (!rank_ct || ranks[rank_ct-1] != (r)) ranks[rank_ct++] = (r);
+    for (int p=0; p< ct; p++){
+        size_t index = pcts[p]*(n-1)/100.0;
+        int is_exact = (index == pcts[p]*(n-1)/100.0);
+        if (rounding == 'u' && !is_exact) index++;
+        Add_rank(index)
+        if (rounding == 'a' && !is_exact) Add_rank(index+1)
+    }
+    multiselect(x, 0, n-1, ranks, rank_ct, 2*(int)(log2(n)+1));
+    for (int p=0; p< ct; p++){
+        size_t index = pcts[p]*(n-1)/100.0;
+        int is_exact = (index == pcts[p]*(n-1)/100.0);
+        if (rounding == 'u' && !is_exact) index++;
+		out[p] = (rounding == 'a' && !is_exact) ? (x[index] + x[index+1])/2. : x[index];
+    }
+    free(ranks);
+}
 
-\li See apop_data_prune_columns for an example.
-*/
-apop_data * apop_data_summarize(apop_data *indata){
-    Apop_stopif(!indata, return NULL, 0, "You sent me a NULL apop_data set. Returning NULL.");
+/* The same, leaving the data alone. */
+void apop_percentiles_select(gsl_vector const *data, char rounding, int const *pcts, int ct, double *out){
+    size_t n = data->size;
+    double *x = malloc(sizeof(double)*n);
+    for (size_t i=0; i< n; i++) x[i] = gsl_vector_get(data, i);
+    select_percentiles(x, n, rounding, pcts, ct, out);
+    free(x);
+}
+
+static apop_data *summarize_page(apop_data *indata){
     Apop_stopif(!indata->matrix, return NULL, 0, "You sent me an apop_data set with a NULL matrix. Returning NULL.");
-    apop_data *out = apop_data_alloc(indata->matrix->size2, 6);
-    double mean, var;
-    char rowname[10000]; //crashes on more than 10^9995 columns.
+    gsl_matrix const *m = indata->matrix;
+    gsl_vector const *w = indata->weights;
+    Apop_stopif(w && w->size != m->size1, apop_return_data_error(d), 0, "The weights vector "
+            "has size %zu, but the matrix has %zu rows. Returning a blank data set with error='d'.",
+            w->size, m->size1);
+    apop_data *out = apop_data_alloc(m->size2, 6);
+    Apop_stopif(out->error, return out, 0, "allocation error.");
 	apop_name_add(out->names, "mean", 'c');
 	apop_name_add(out->names, "std dev", 'c');
 	apop_name_add(out->names, "variance", 'c');
@@ -405,28 +721,81 @@ apop_data * apop_data_summarize(apop_data *indata){
         }
     }
 	else
-		for (size_t i=0; i< indata->matrix->size2; i++){
-			sprintf(rowname, "col %zu", i);
+		for (size_t i=0; i< m->size2; i++){
+            char *rowname;
+			Asprintf(&rowname, "col %zu", i);
 			apop_name_add(out->names, rowname, 'r');
+            free(rowname);
 		}
-	for (size_t i=0; i< indata->matrix->size2; i++){
-        gsl_vector *v = Apop_cv(indata, i);
-        if (!indata->weights){
-            mean = apop_vector_mean(v);
-            var  = apop_vector_var_m(v, mean);
-        } else {
-            mean = apop_vector_mean(v, indata->weights);
-            var  = apop_vector_var(v, indata->weights);
-        } 
-        double *pctiles = apop_vector_percentiles(v);
+    if (!m->size1) {
+        gsl_matrix_set_all(out->matrix, GSL_NAN);
+        return out;
+    }
+    /* Each column is copied once into contiguous scratch space; the moments come from
+     one blocked pass over the copy, and min, median, and max from one multi-rank
+     selection on it. Columns are independent, so they are spread over threads. */
+    OMP_for (size_t i=0; i< m->size2; i++){
+        double *x = malloc(sizeof(double)*m->size1);
+        if (!x){
+            OMP_critical(summarize_err)
+            out->error = 'a';
+            continue;
+        }
+        for (size_t r=0; r< m->size1; r++) x[r] = m->data[r*m->tda + i];
+        long double wsum, mean, m2;
+        apop_fused_moments(x, 1, w ? w->data : NULL, w ? w->stride : 0, m->size1, &wsum, &mean, &m2);
+        double var;
+        if (!w) var = m2/(wsum-1);
+        else {
+            double len = (wsum < 1.1 ? w->size : wsum);
+            var = m2/wsum * len/(len -1.);
+        }
+        double pctiles[3];
+        select_percentiles(x, m->size1, 'd', (int[]){0, 50, 100}, 3, pctiles);
+        free(x);
 		gsl_matrix_set(out->matrix, i, 0, mean);
 		gsl_matrix_set(out->matrix, i, 1, sqrt(var));
 		gsl_matrix_set(out->matrix, i, 2, var);
 		gsl_matrix_set(out->matrix, i, 3, pctiles[0]);
-		gsl_matrix_set(out->matrix, i, 4, pctiles[50]);
-		gsl_matrix_set(out->matrix, i, 5, pctiles[100]);
-        free(pctiles);
+		gsl_matrix_set(out->matrix, i, 4, pctiles[1]);
+		gsl_matrix_set(out->matrix, i, 5, pctiles[2]);
 	}
+    Apop_stopif(out->error, , 0, "allocation error.");
+	return out;
+}
+
+/** Put summary information about the columns of a table (mean, std dev, variance, min, median, max) in a table.
+
+\param indata The table to be summarized. An \ref apop_data structure. May have a <tt>weights</tt> element.
+\param all_pages If \c 'y', summarize every page of \c indata that has a matrix, and chain the
+summaries together as pages of the output, in the same order. If \c 'n', summarize only the
+first page. (default: \c 'n')
+\return     An \ref apop_data structure with one row for each column in the original
+            table, and a column for each summary statistic.
+\exception out->error='a'  Allocation error.
+
+\li This function gives more columns than you probably want; use \ref apop_data_prune_columns to pick the ones you want to see.
+\li Each column takes one pass for the moments and a selection (not a sort) for the
+order statistics, and columns are summarized in parallel when Apophenia is built with OpenMP.
+\li This function uses the \ref designated syntax for inputs.
+
+\li See apop_data_prune_columns for an example.
+*/
+APOP_VAR_HEAD apop_data * apop_data_summarize(apop_data *indata, char all_pages){
+    apop_data * apop_varad_var(indata, NULL);
+    Apop_stopif(!indata, return NULL, 0, "You sent me a NULL apop_data set. Returning NULL.");
+    char apop_varad_var(all_pages, 'n');
+APOP_VAR_ENDHEAD
+    if (all_pages != 'y' && all_pages != 'Y') return summarize_page(indata);
+    apop_data *out = NULL, *last = NULL;
+    for (apop_data *page = indata; page; page = page->more){
+        if (!page->matrix) continue;
+        apop_data *summary = summarize_page(page);
+        if (!out) out = summary;
+        else last->more = summary;
+        last = summary;
+    }
+    Apop_stopif(!out, return NULL, 0, "None of the pages of your data set has a matrix. Returning NULL.");
 	return out;
 }
 
@@ -444,26 +813,20 @@ up (use the next highest value); if \c 'd', round down to the next lowest value;
 the sample is below returned_vector[5]"; if \c 'd' or \c 'a', then you can say "5%
 or more of the sample is above returned_vector[5]".
 \li You may eventually want to \c free() the array returned by this function.
+\li The percentiles are found by selection on a copy of the data, which is \f$O(n)\f$
+for each distinct rank needed, rather than by a full sort.
 \li This function uses the \ref designated syntax for inputs.
 */ 
 APOP_VAR_HEAD double * apop_vector_percentiles(gsl_vector *data, char rounding){
     gsl_vector *apop_varad_var(data, NULL);
     Apop_stopif(!data, return NULL, 0, "You gave me NULL data.");
+    Apop_stopif(!data->size, return NULL, 0, "You gave me a zero-length vector.");
     char apop_varad_var(rounding, 'd');
 APOP_VAR_ENDHEAD
-    gsl_vector *sorted	= gsl_vector_alloc(data->size);
-    double     *pctiles = malloc(sizeof(double) * 101);
-	gsl_vector_memcpy(sorted,data);
-	gsl_sort_vector(sorted);
-	for(int i=0; i<101; i++){
-		int index = i*(data->size-1)/100.0;
-		if (rounding == 'u' && index != i*(data->size-1)/100.0)
-			index ++; //index was rounded down, but should be rounded up.
-		if (rounding == 'a' && index != i*(data->size-1)/100.0)
-            pctiles[i]	= (gsl_vector_get(sorted, index)+gsl_vector_get(sorted, index+1))/2.;
-        else pctiles[i]	= gsl_vector_get(sorted, index);
-	}
-	gsl_vector_free(sorted);
+    int all[101];
+    for (int i=0; i< 101; i++) all[i] = i;
+    double *pctiles = malloc(sizeof(double) * 101);
+    apop_percentiles_select(data, rounding, all, 101, pctiles);
 	return pctiles;
 }
 
@@ -479,13 +842,10 @@ APOP_VAR_HEAD double apop_vector_mean(gsl_vector const *v, gsl_vector const *wei
     gsl_vector const * apop_varad_var(weights, NULL);
     Check_vw
 APOP_VAR_END_HEAD
-    if (!weights) return gsl_stats_mean(v->data, v->stride, v->size);
-    long double sum = 0, wsum = 0;
-    for (size_t i=0; i< weights->size; i++){
-        sum  += gsl_vector_get(weights, i) * gsl_vector_get(v,i); 
-        wsum += gsl_vector_get(weights, i); 
-    }
-    return sum/wsum;
+    if (!weights) return apop_compensated_sum(v->data, v->stride, v->size)/v->size;
+    long double mean;
+    apop_fused_moments(v->data, v->stride, weights->data, weights->stride, v->size, NULL, &mean, NULL);
+    return mean;
 }
 
 /** Find the sample variance of a vector, weighted or unweighted.
@@ -510,18 +870,12 @@ APOP_VAR_HEAD double apop_vector_var(gsl_vector const *v, gsl_vector const *weig
     gsl_vector const * apop_varad_var(weights, NULL);
     Check_vw
 APOP_VAR_END_HEAD
-    if (!weights) return gsl_stats_variance(v->data, v->stride, v->size);
-    //Using the E(x^2) - E^2(x) form.
-    long double sum = 0, wsum = 0, sumsq = 0, vv, ww;
-    for (size_t i=0; i< weights->size; i++){
-        vv = gsl_vector_get(v, i);
-        ww = gsl_vector_get(weights, i);
-        sum   += ww * vv;
-        sumsq += ww * gsl_pow_2(vv); 
-        wsum  += ww; 
-    }
+    long double wsum, m2;
+    apop_fused_moments(v->data, v->stride, weights ? weights->data : NULL,
+                          weights ? weights->stride : 0, v->size, &wsum, NULL, &m2);
+    if (!weights) return m2/(wsum-1);
     double len = (wsum < 1.1 ? weights->size : wsum);
-    return (sumsq/len - gsl_pow_2(sum/len)) * len/(len -1.);
+    return m2/wsum * len/(len -1.);
 }
 
 /** Find the sample covariance of a pair of vectors, with an optional weighting. This only
@@ -531,6 +885,9 @@ makes sense if the weightings are identical, so the function takes only one weig
 \param  weights The weight vector. (default equal weights for all elements)
 \return The sample covariance
 
+\li Weights are read as per \ref apop_vector_var, and the covariance is found the same
+way, from deviations around the means rather than \f$E(xy)-E(x)E(y)\f$, so
+<tt>apop_vector_cov(v, v, w)</tt> is exactly <tt>apop_vector_var(v, w)</tt>.
 \li This function uses the \ref designated syntax for inputs.
 */
 APOP_VAR_HEAD double apop_vector_cov(const gsl_vector *v1, const gsl_vector *v2, const gsl_vector *weights){
@@ -545,20 +902,29 @@ APOP_VAR_HEAD double apop_vector_cov(const gsl_vector *v1, const gsl_vector *v2,
     Apop_stopif(weights && ((weights->size != v1->size) || (weights->size != v2->size)), return GSL_NAN, 0, "data vectors have sizes %zu and %zu; weighting vector has size %zu. Returning NaN.", v1->size, v2->size, weights->size);
 
 APOP_VAR_ENDHEAD
-    if (!weights) return gsl_stats_covariance(v1->data, v1->stride, v2->data, v2->stride, v2->size);
-    long double sum1 = 0, sum2 = 0, wsum = 0, sumsq = 0, vv1, vv2, ww;
-    //Using the E(x^2) - E^2(x) form.
-    for (size_t i=0; i< weights->size; i++){
-        vv1   = gsl_vector_get(v1,i);
-        vv2   = gsl_vector_get(v2,i);
-        ww    = gsl_vector_get(weights,i);
-        sum1 += ww * vv1;
-        sum2 += ww * vv2;
-        sumsq+= ww * vv1 * vv2;
-        wsum += ww; 
-    }
+    long double wsum, cm;
+    fused_comoments(v1->data, v1->stride, v2->data, v2->stride, weights ? weights->data : NULL,
+                          weights ? weights->stride : 0, v1->size, &wsum, NULL, &cm);
+    if (!weights) return cm/(wsum-1);
     double len = (wsum < 1.1 ? weights->size : wsum);
-    return (sumsq/len  - sum1*sum2/gsl_pow_2(len)) *(len/(len-1));
+    return cm/wsum * len/(len -1.);
+}
+
+#define Cov_block 512
+
+/* Column means, weighted or not, in one row-wise pass. Returns the total weight. */
+static long double column_means(gsl_matrix const *m, gsl_vector const *w, gsl_vector *means){
+    long double *sums = calloc(m->size2, sizeof(long double)), wsum = 0;
+    for (size_t i=0; i< m->size1; i++){
+        double const *row = m->data + i*m->tda;
+        double wi = w ? gsl_vector_get(w, i) : 1;
+        if (!wi) continue;
+        for (size_t j=0; j< m->size2; j++) sums[j] += wi*row[j];
+        wsum += wi;
+    }
+    for (size_t j=0; j< m->size2; j++) gsl_vector_set(means, j, sums[j]/wsum);
+    free(sums);
+    return wsum;
 }
 
 /** Returns the sample variance/covariance matrix relating each column of the matrix to each other column.
@@ -572,23 +938,55 @@ int size=indata->matrix->size1;
 gsl_matrix_scale(popcov->matrix, size/(size-1.));
 \endcode
 
+\li Weights are read as per \ref apop_vector_var: if they sum to more than one, they
+are taken as replication counts; else \f$n\f$ is the number of rows. Weights must
+not be negative.
+
+\li The whole matrix is found at once: blocks of rows are centered (and scaled by the
+square root of their weights) into a buffer, and each block is added in via a single
+BLAS symmetric rank-\f$k\f$ update. So this is two passes over the data, not one pass
+per pair of columns.
+
 \return Returns an \ref apop_data set the variance/covariance matrix.  
 \exception out->error='a'  Allocation error.
+\exception out->error='w'  A negative weight.
 */
 apop_data *apop_data_covariance(const apop_data *in){
     Apop_stopif(!in, return NULL, 1, "You sent me a NULL apop_data set. Returning NULL.");
     Apop_stopif(!in->matrix, return NULL, 1, "You sent me an apop_data set with a NULL matrix. Returning NULL.");
-    apop_data *out = apop_data_alloc(in->matrix->size2, in->matrix->size2);
+    gsl_matrix const *m = in->matrix;
+    gsl_vector const *w = in->weights;
+    size_t k = m->size2;
+    apop_data *out = apop_data_calloc(k, k);
     Apop_stopif(out->error, return out, 0, "allocation error.");
-    for (size_t i=0; i < in->matrix->size2; i++){
-        for (size_t j=i; j < in->matrix->size2; j++){
-            double var = apop_vector_cov(Apop_cv(in, i), Apop_cv(in, j), in->weights);
-            gsl_matrix_set(out->matrix, i,j, var);
-            if (i!=j) gsl_matrix_set(out->matrix, j,i, var);
+    Apop_stopif(w && w->size != m->size1, out->error='w'; return out, 0, "The data set has %zu rows, but %zu weights.", m->size1, w->size);
+    if (w) Apop_stopif(gsl_vector_min(w) < 0, out->error='w'; return out, 0, "I can't use negative weights.");
+
+    gsl_vector *means = gsl_vector_alloc(k);
+    gsl_matrix *block = gsl_matrix_alloc(GSL_MIN(Cov_block, GSL_MAX(m->size1, 1)), k);
+    Apop_stopif(!means || !block, out->error='a'; goto done, 0, "allocation error.");
+    long double wsum = column_means(m, w, means);
+    for (size_t start=0; start< m->size1; start+=Cov_block){
+        size_t rows = GSL_MIN(Cov_block, m->size1 - start);
+        for (size_t i=0; i< rows; i++){
+            double const *row = m->data + (start+i)*m->tda;
+            double *brow = block->data + i*block->tda;
+            double sw = w ? sqrt(gsl_vector_get(w, start+i)) : 1;
+            for (size_t j=0; j< k; j++) brow[j] = sw*(row[j] - means->data[j]);
         }
+        gsl_blas_dsyrk(CblasUpper, CblasTrans, 1, Apop_subm(block, 0, 0, rows, k), 1, out->matrix);
     }
+    double len = !w ? wsum : (wsum < 1.1 ? w->size : wsum);
+    gsl_matrix_scale(out->matrix, len/(wsum*(len-1.)));
+    for (size_t i=0; i< k; i++)
+        for (size_t j=i+1; j< k; j++)
+            gsl_matrix_set(out->matrix, j, i, gsl_matrix_get(out->matrix, i, j));
     apop_name_stack(out->names, in->names, 'c');
     apop_name_stack(out->names, in->names, 'r', 'c');
+
+    done:
+    gsl_vector_free(means);
+    gsl_matrix_free(block);
     return out;
 }
 
@@ -596,17 +994,23 @@ apop_data *apop_data_covariance(const apop_data *in){
 
 \param in 	A data matrix: rows are observations, columns are variables. If you give me a weights vector, I'll use it.
 
+\li The standard deviations are read from the diagonal of \ref apop_data_covariance, so there are no further passes over the data.
+
 \return Returns the square variance/covariance matrix with dimensions equal to the number of input columns.
 \exception out->error='a'  Allocation error.
 */
 apop_data *apop_data_correlation(const apop_data *in){
     apop_data *out = apop_data_covariance(in);
-    if (!out) return NULL;
-    for(size_t i=0; i< in->matrix->size2; i++){
-        double std_dev = sqrt(apop_vector_var(Apop_cv(in, i), in->weights));
-        gsl_vector_scale(Apop_cv(out, i), 1.0/std_dev);
-        gsl_vector_scale(Apop_rv(out, i), 1.0/std_dev);
+    if (!out || out->error) return out;
+    size_t k = out->matrix->size1;
+    gsl_vector *inv_sd = gsl_vector_alloc(k);
+    for (size_t i=0; i< k; i++)
+        gsl_vector_set(inv_sd, i, 1./sqrt(gsl_matrix_get(out->matrix, i, i)));
+    for(size_t i=0; i< k; i++){
+        gsl_vector_scale(Apop_cv(out, i), gsl_vector_get(inv_sd, i));
+        gsl_vector_scale(Apop_rv(out, i), gsl_vector_get(inv_sd, i));
     }
+    gsl_vector_free(inv_sd);
     return out;
 }
 
@@ -0,0 +1,227 @@
+/** \file
+  A mergeable sketch of a distribution, for percentiles in bounded memory. */
+/* Copyright (c) 2026 by Ben Klemens.  Licensed under the GPLv2; see COPYING.  */
+
+#include "apop_internal.h"
+
+/* The merging t-digest of Dunning and Ertl, <em>Computing extremely accurate quantiles
+using t-digests</em> (2019). Points are appended to a buffer after the centroids; when
+the buffer fills, everything is sorted and adjacent items are merged, as long as the
+merged centroid spans no more than one unit of the scale function
+k(q) = compression/(2 pi) asin(2q-1). That function is flat in the middle and steep at
+the tails, so centroids near the extremes stay small and the tails stay accurate. */
+
+typedef struct {double mean, weight;} centroid;
+
+static int centroid_cmp(void const *a, void const *b){
+    double ma = ((centroid const*)a)->mean, mb = ((centroid const*)b)->mean;
+    return (ma > mb) - (ma < mb);
+}
+
+static double scale_k(double q, double compression){ return compression/(2*M_PI) * asin(2*q-1); }
+static double scale_q(double k, double compression){ return (sin(GSL_MIN(k*2*M_PI/compression, M_PI/2))+1)/2; }
+
+static void compress(apop_tdigest *t){
+    size_t n = t->centroid_ct + t->unmerged_ct;
+    if (!t->unmerged_ct || n < 2) {t->centroid_ct = n; t->unmerged_ct = 0; return;}
+    centroid *c = malloc(sizeof(centroid)*n);
+    for (size_t i=0; i< n; i++) c[i] = (centroid){t->means[i], t->weights[i]};
+    qsort(c, n, sizeof(centroid), centroid_cmp);
+    double W = t->total_weight, so_far = 0;
+    double limit = W * scale_q(scale_k(0, t->compression)+1, t->compression);
+    size_t out = 0;
+    for (size_t i=1; i< n; i++){
+        if (so_far + c[out].weight + c[i].weight <= limit){
+            c[out].weight += c[i].weight;
+            c[out].mean += (c[i].mean - c[out].mean) * c[i].weight/c[out].weight;
+        } else {
+            so_far += c[out].weight;
+            limit = W * scale_q(scale_k(so_far/W, t->compression)+1, t->compression);
+            c[++out] = c[i];
+        }
+    }
+    t->centroid_ct = out+1;
+    t->unmerged_ct = 0;
+    for (size_t i=0; i< t->centroid_ct; i++){
+        t->means[i] = c[i].mean;
+        t->weights[i] = c[i].weight;
+    }
+    free(c);
+}
+
+/** Allocate an empty t-digest, a mergeable sketch of a distribution from which you can
+read approximate percentiles and CDF values, using memory bounded by the compression
+parameter rather than by the size of the data.
+
+\code
+apop_tdigest *t = apop_tdigest_alloc(200);
+apop_tdigest_add_query(t, "select income, weight from survey");
+printf("median: %g; 99th percentile: %g\n", apop_tdigest_median(t), apop_tdigest_quantile(t, 0.99));
+apop_tdigest_free(t);
+\endcode
+
+\li Feed the digest with \ref apop_tdigest_add, \ref apop_tdigest_add_vector, \ref
+apop_tdigest_add_data, or \ref apop_tdigest_add_query. Combine digests built on
+separate threads or files with \ref apop_tdigest_merge. Read results with \ref
+apop_tdigest_quantile, \ref apop_tdigest_median, \ref apop_tdigest_percentiles, and \ref
+apop_tdigest_cdf.
+\li Accuracy is best at the tails: the error at quantile \f$q\f$ is roughly
+proportional to \f$\sqrt{q(1-q)}\f$/compression. The minimum and maximum are exact.
+\li With SQLite, the same sketch is available in queries via the \c quantile(x, q) and
+\c median(x) aggregates, e.g. <tt>select state, median(income), quantile(income, .9) from survey group by state</tt>.
+\li \c NaNs are ignored.
+
+\param compression The accuracy parameter: the digest holds at most about this many
+centroids. If zero, use 100.
+\return An empty digest, or \c NULL on allocation failure.
+*/
+apop_tdigest *apop_tdigest_alloc(double compression){
+    if (compression <= 0) compression = 100;
+    apop_tdigest *out = malloc(sizeof(apop_tdigest));
+    Apop_stopif(!out, return NULL, 0, "allocation error.");
+    size_t capacity = 6*ceil(compression) + 10;
+    *out = (apop_tdigest){.compression=compression, .capacity=capacity,
+                .min=GSL_POSINF, .max=GSL_NEGINF,
+                .means=malloc(sizeof(double)*capacity), .weights=malloc(sizeof(double)*capacity)};
+    Apop_stopif(!out->means || !out->weights, apop_tdigest_free(out); return NULL, 0, "allocation error.");
+    return out;
+}
+
+/** Free an \ref apop_tdigest. */
+void apop_tdigest_free(apop_tdigest *t){
+    if (!t) return;
+    free(t->means);
+    free(t->weights);
+    free(t);
+}
+
+/** Add one observation to an \ref apop_tdigest.
+
+\param t The digest.
+\param x The observation. \c NaNs are ignored.
+\param weight Its weight, which must not be negative. Zero-weight observations are ignored.
+*/
+void apop_tdigest_add(apop_tdigest *t, double x, double weight){
+    Apop_stopif(weight < 0, return, 0, "I can't use a negative weight (%g).", weight);
+    if (isnan(x) || !weight) return;
+    if (t->centroid_ct + t->unmerged_ct == t->capacity){
+        compress(t);
+        if (t->centroid_ct > t->capacity/2){ //shouldn't happen, but better to grow than to loop.
+            t->capacity *= 2;
+            t->means = realloc(t->means, sizeof(double)*t->capacity);
+            t->weights = realloc(t->weights, sizeof(double)*t->capacity);
+        }
+    }
+    size_t i = t->centroid_ct + t->unmerged_ct++;
+    t->means[i] = x;
+    t->weights[i] = weight;
+    t->total_weight += weight;
+    t->min = GSL_MIN(t->min, x);
+    t->max = GSL_MAX(t->max, x);
+}
+
+/** Add every element of a vector to an \ref apop_tdigest.
+
+\param t The digest.
+\param v The data.
+\param weights Weights for the elements of \c v, or \c NULL for equal weights.
+*/
+void apop_tdigest_add_vector(apop_tdigest *t, gsl_vector const *v, gsl_vector const *weights){
+    if (!v) return;
+    Apop_stopif(weights && weights->size != v->size, return, 0, "The data vector has %zu "
+            "elements, but the weight vector has %zu.", v->size, weights->size);
+    for (size_t i=0; i< v->size; i++)
+        apop_tdigest_add(t, gsl_vector_get(v, i), weights ? gsl_vector_get(weights, i) : 1);
+}
+
+/** Add every element of the vector and matrix of an \ref apop_data set to an \ref
+apop_tdigest. If the set has weights, every element of a row gets that row's weight.
+To summarize a single column, send a view like <tt>Apop_c(d, 3)</tt>.
+*/
+void apop_tdigest_add_data(apop_tdigest *t, apop_data const *d){
+    if (!d) return;
+    apop_tdigest_add_vector(t, d->vector, d->weights);
+    if (d->matrix) for (size_t j=0; j< d->matrix->size2; j++)
+        apop_tdigest_add_vector(t, Apop_mcv(d->matrix, j), d->weights);
+}
+
+/** Fold one \ref apop_tdigest into another. The result is as if all the data sent to
+\c from had been sent to \c into (up to the approximation).
+
+\param into The digest that will hold the combined sketch.
+\param from The digest to add in. It is not modified.
+*/
+void apop_tdigest_merge(apop_tdigest *into, apop_tdigest const *from){
+    if (!into || !from || into == from) return;
+    for (size_t i=0; i< from->centroid_ct + from->unmerged_ct; i++)
+        apop_tdigest_add(into, from->means[i], from->weights[i]);
+    into->min = GSL_MIN(into->min, from->min);
+    into->max = GSL_MAX(into->max, from->max);
+}
+
+/** The approximate value at quantile \c q of the data sent to an \ref apop_tdigest.
+
+\param t The digest. Any unmerged points are merged in first, which is why it isn't \c const.
+\param q A number in \f$[0, 1]\f$.
+\return The approximate quantile; \c NaN if the digest is empty or \c q is out of range.
+*/
+double apop_tdigest_quantile(apop_tdigest *t, double q){
+    Apop_stopif(!t || !(q >= 0 && q <= 1), return GSL_NAN, 0, "Quantile %g is not in [0, 1].", q);
+    compress(t);
+    size_t n = t->centroid_ct;
+    if (!n) return GSL_NAN;
+    if (q == 0) return t->min;
+    if (q == 1) return t->max;
+    double target = q * t->total_weight;
+    double *w = t->weights, *m = t->means;
+    if (target <= w[0]/2) return t->min + (m[0]-t->min) * target/(w[0]/2);
+    double center = w[0]/2;
+    for (size_t i=0; i+1< n; i++){
+        double next = center + (w[i]+w[i+1])/2;
+        if (target <= next)
+            return m[i] + (m[i+1]-m[i]) * (target-center)/(next-center);
+        center = next;
+    }
+    double tail = t->total_weight - center; //== w[n-1]/2
+    return m[n-1] + (t->max - m[n-1]) * (target-center)/tail;
+}
+
+/** The approximate median of the data sent to an \ref apop_tdigest. */
+double apop_tdigest_median(apop_tdigest *t){ return apop_tdigest_quantile(t, 0.5); }
+
+/** The approximate percentiles of the data sent to an \ref apop_tdigest, in the format of
+\ref apop_vector_percentiles: an array of 101 elements, where element 0 is the minimum,
+element 100 is the maximum, and element 95 is the 95th percentile.
+
+\return The array, which you may eventually want to \c free; \c NULL if the digest is empty.
+*/
+double *apop_tdigest_percentiles(apop_tdigest *t){
+    Apop_stopif(!t || !t->total_weight, return NULL, 1, "Empty digest; returning NULL.");
+    double *out = malloc(sizeof(double)*101);
+    for (int i=0; i< 101; i++) out[i] = apop_tdigest_quantile(t, i/100.);
+    return out;
+}
+
+/** The approximate share of the data sent to an \ref apop_tdigest that is less than or
+equal to \c x; the inverse of \ref apop_tdigest_quantile.
+
+\return A number in \f$[0, 1]\f$; \c NaN if the digest is empty.
+*/
+double apop_tdigest_cdf(apop_tdigest *t, double x){
+    Apop_stopif(!t, return GSL_NAN, 0, "NULL digest.");
+    compress(t);
+    size_t n = t->centroid_ct;
+    if (!n || isnan(x)) return GSL_NAN;
+    if (x < t->min) return 0;
+    if (x >= t->max) return 1;
+    double W = t->total_weight, *w = t->weights, *m = t->means;
+    if (x < m[0]) return (m[0] > t->min ? (x-t->min)/(m[0]-t->min) : 0) * w[0]/2/W;
+    double center = w[0]/2;
+    for (size_t i=0; i+1< n; i++){
+        double next = center + (w[i]+w[i+1])/2;
+        if (x < m[i+1])
+            return (center + (next-center) * (x-m[i])/(m[i+1]-m[i]))/W;
+        center = next;
+    }
+    return (center + (W-center) * (t->max > m[n-1] ? (x-m[n-1])/(t->max-m[n-1]) : 1))/W;
+}
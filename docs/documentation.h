@@ -844,6 +844,7 @@ manipulate the \ref apop_data structure and its components.
 \li\ref apop_vector_stack
 \li\ref apop_vector_realloc
 \li\ref apop_vector_unique_elements
+\li\ref apop_vector_unique_counts
 
 Apophenia builds upon the GSL, but it would be inappropriate to redundantly replicate
 the <a href="http://www.gnu.org/software/gsl/manual/html_node/index.html">GSL's documentation</a> here.
@@ -1168,6 +1169,7 @@ you'll find in the SQLite documentation. See \ref apop_rng_get_thread() to use t
 \li\ref apop_vector_log : take the natural log of every element of a vector
 \li\ref apop_vector_log10 : take the log (base 10) of every element of a vector
 \li\ref apop_vector_distance : find the distance between two vectors via various metrics
+\li\ref apop_data_distance_matrix : find the distances (or Gaussian kernel) between all rows of one or two data sets
 \li\ref apop_vector_normalize : scale/shift a matrix to have mean zero, sum to one, have a range of exactly \f$[0, 1]\f$, et cetera
 \li\ref apop_vector_entropy : calculate the entropy of a vector of frequencies or probabilities
 
@@ -1190,8 +1192,10 @@ See also:
 \section  matrixmath  Matrix math
 
 \li\ref apop_dot : matrix \f$\cdot\f$ matrix, matrix \f$\cdot\f$ vector, or vector \f$\cdot\f$ matrix
+\li\ref apop_dot_into : the same, writing \f$\alpha d_1\cdot d_2 + \beta C\f$ into an existing output \f$C\f$
 \li\ref apop_matrix_determinant
 \li\ref apop_matrix_inverse
+\li\ref apop_matrix_inverse_into : invert into an existing matrix, or in place
 \li\ref apop_det_and_inv : find determinant and inverse at the same time
 
 See the GSL documentation for myriad further options.
@@ -1200,7 +1204,26 @@ See the GSL documentation for myriad further options.
 \section  sumstats  Summary stats
 
 \li\ref apop_data_summarize
+\li\ref apop_accumulator_alloc : summarize data that arrives in chunks, or across threads
+\li\ref apop_accumulator_add
+\li\ref apop_accumulator_merge
+\li\ref apop_accumulator_summarize
+\li\ref apop_accumulator_covariance
+\li\ref apop_accumulator_free
+\li\ref apop_tdigest_alloc : approximate percentiles in bounded memory, mergeable across threads or files
+\li\ref apop_tdigest_add
+\li\ref apop_tdigest_add_vector
+\li\ref apop_tdigest_add_data
+\li\ref apop_tdigest_add_query
+\li\ref apop_tdigest_merge
+\li\ref apop_tdigest_quantile
+\li\ref apop_tdigest_median
+\li\ref apop_tdigest_percentiles
+\li\ref apop_tdigest_cdf
+\li\ref apop_tdigest_free
 \li\ref apop_vector_moving_average
+\li\ref apop_vector_rolling : moving mean, variance, min, max, median, or quantile over a trailing or centered window
+\li\ref apop_vector_rolling_cov
 \li\ref apop_vector_percentiles
 \li\ref apop_vector_bounded
 
@@ -1379,6 +1402,7 @@ functions.
 \li\ref apop_text_set : replace a single cell of the text grid with new text.
 \li\ref apop_text_paste : convert a table of strings into one long string.
 \li\ref apop_text_unique_elements : get a sorted list of unique elements for one column of text.
+\li\ref apop_text_unique_counts : the same, with a count of how often each appears.
 \li\ref apop_text_free : you may never need this, because \ref apop_data_free calls it.
 \li\ref apop_regex : friendlier front-end for POSIX-standard regular expression
             searching; pulls matches into an \ref apop_data set.
@@ -1503,6 +1527,16 @@ multiply the skew by    \f$(n-1)(n-2)/n^2\f$. The equation for the unbiased samp
 as calculated in <a href="http://modelingwithdata.org/pdfs/moments.pdf">Appendix M of
 <em>Modeling with Data</em></a> is not quite as easy to adjust.
 
+\li For percentiles, <tt>median(x)</tt> and <tt>quantile(x, q)</tt> (where \f$q\in[0,1]\f$)
+aggregate the column into an \ref apop_tdigest, so they run in bounded memory but are
+approximate (the min and max, at \f$q=0\f$ and \f$q=1\f$, are exact):
+
+\code
+select state, median(income), quantile(income, 0.9)
+from table
+group by state
+\endcode
+
 \li Also provided: wrapper functions for standard math library
 functions---<tt>sqrt(x)</tt>, <tt>pow(x,y)</tt>, <tt>exp(x)</tt>, <tt>log(x)</tt>,
 and trig functions. They call the standard math library function of the same name
@@ -2161,6 +2195,20 @@ colling program, not the values returned by the likelihood function.  If you kno
 function is globally convex (as are most standard probability functions), then this
 method is overkill.
 
+Parallel tempering (<tt>.method="Parallel tempering"</tt>) trades the cooling schedule
+for a ladder of \c replicas walks, each at a fixed temperature, spaced geometrically
+from \c t_min up to \c t_initial. Every round, each walk takes \c iters_fixed_T steps
+(of size \c step_size, scaled down for the colder walks), and then neighboring walks may
+swap positions, with the usual Metropolis probability. Hot walks roam the surface
+and hand good regions down to the cold walks, which refine them. The number of rounds
+is the number of temperature drops an annealing run with the same \c t_initial, \c t_min,
+and \c mu_t would take. Each walk has its own random number stream seeded from the \c
+rng. If the \c threaded element of the \ref apop_mle_settings group is \c 'y', the walks
+run in parallel, each on its own copy of the model; by default they run one after
+another. The results are identical either way, and do not depend on the number of threads. The output
+model's info page reports the number of replicas and the share of proposed swaps
+accepted.
+
 
 \section mlfns Useful functions
 
@@ -2180,7 +2228,7 @@ Some functions for missing data:
 
 A few more descriptive methods:
 
-\li\ref apop_matrix_pca : Principal component analysis
+\li\ref apop_matrix_pca : Principal component analysis, exact or randomized and truncated
 \li\ref apop_anova : One-way or two-way ANOVA tables
 \li\ref apop_rake : Iterative proportional fitting on large, sparse tables
 
@@ -2844,6 +2892,7 @@ This page includes:
 \li \ref write_likelihoods of writing a new model from scratch.
 \li \ref settingswriting, covering the writing of <em>ad hoc</em> structures to hold model- or method-specific details, like the number of periods for burning in an MCMC run or the number of bins in a histogram.
 \li \ref vtables, covering the means of writing special-case routines for functions that are not part of the \ref apop_model itself, including the score or conjugate prior/likelihood pairs for \ref apop_update.
+\li \ref dualsec, on getting exact gradients from a log likelihood written with dual numbers.
 \li \ref modeldataparts, a detailed list of the requirements for the non-function elements of an \ref apop_model.
 \li \ref methodsection, a detailed list of requirements for the function elements of an \ref apop_model.
 
@@ -3093,6 +3142,61 @@ example, the update vtable associates functions with the \c draw, \c log_likelih
 and \p methods of the model. A model where these elements are identical 
 will still match even if other elements are different.
 
+\section dualsec Exact gradients via dual numbers
+
+If your model has no hand-written score, \ref apop_score and the gradient-based
+maximum likelihood methods fall back to a numerical gradient. That costs two
+evaluations of the log likelihood per parameter, and inherits the accuracy problems
+of finite differences. An alternative is forward-mode automatic differentiation.
+
+A dual number carries a value, \c val, and its derivative with respect to one chosen
+input, \c dx. Write a log likelihood using these functions in place of the usual
+arithmetic, and every intermediate result carries its derivative along with it, so
+the final result's \c dx is the exact derivative of the log likelihood: no step sizes,
+no finite-difference error.
+
+To take the gradient, \ref apop_dual_score evaluates the log likelihood once per
+parameter, each time with that parameter's \c dx set to one and all others to zero.
+Given a model with \f$k\f$ parameters, that's \f$k\f$ evaluations of the dual log likelihood,
+versus the \f$2k\f$ evaluations of the plain log likelihood taken by \ref apop_numerical_gradient.
+
+Register the dual log likelihood for your model in its \c prep method, and \ref
+apop_score and the gradient-based maximum likelihood methods will use it whenever the
+model has no hand-written score. The typedef and hash:
+
+\code
+typedef apop_dual (*apop_dual_ll_type)(apop_data *d, apop_dual const *params, apop_model *m);
+#define apop_dual_ll_hash(m1) ((size_t)((m1)->log_likelihood ? (m1)->log_likelihood : (m1)->p))
+\endcode
+
+The \c params are the model's parameters, in \ref apop_data_pack order. Here is the
+log likelihood of a Poisson distribution, whose one parameter is \f$\lambda\f$:
+
+\code
+static apop_dual poisson_dual_ll(apop_data *d, apop_dual const *params, apop_model *m){
+    apop_dual ll = apop_dual_const(0),
+              lnlambda = apop_dual_log(params[0]);
+    for (size_t i=0; i< d->vector->size; i++){
+        double x = d->vector->data[i];
+        ll = apop_dual_add(ll, apop_dual_sub(apop_dual_scale(lnlambda, x), params[0]));
+        ll.val -= lgamma(x+1); //a constant: no need to carry it as a dual.
+    }
+    return ll;
+}
+
+//in the prep method:
+apop_dual_ll_vtable_add(poisson_dual_ll, your_model);
+\endcode
+
+The functions:
+
+\li\ref apop_dual_const
+\li\ref apop_dual_add, \ref apop_dual_sub, \ref apop_dual_mul, \ref apop_dual_div, \ref apop_dual_scale
+\li\ref apop_dual_exp, \ref apop_dual_log, \ref apop_dual_sqrt, \ref apop_dual_pow
+\li\ref apop_dual_lgamma
+\li\ref apop_dual_normal_cdf
+\li\ref apop_dual_score
+
 \section modeldataparts The data elements
 
 The remainder of this section covers the detailed expectations regarding the elements
@@ -12,42 +12,149 @@ matrix a \f$1\times 1\f$ matrix. This differs from the setup for \ref apop_norma
 outputs a single vector with \f$\mu\f$ in element zero and \f$\sigma\f$ in element one.
 
 After estimation, the <tt>\<Covariance\></tt> page gives the covariance matrix of the means.
+
+\adoc    Settings   The model keeps the Cholesky factor of the covariance in an \ref
+apop_mvn_settings group, and refactors only when the covariance changes. The group is
+added at prep time; a log likelihood or draw takes a reference to the current factor, so
+threads may evaluate or draw from one model at once. Changing the covariance while another
+thread reads the parameters is still a data race, as with any model.
 */
  
 #include "apop_internal.h"
 
-static double x_prime_sigma_x(gsl_vector *x, gsl_matrix *sigma){
-    gsl_vector * sigma_dot_x = gsl_vector_calloc(x->size);
-    double the_result;
-    gsl_blas_dsymv(CblasUpper, 1, sigma, x, 0, sigma_dot_x); //sigma should be symmetric
-    gsl_blas_ddot(x, sigma_dot_x, &the_result);
-    gsl_vector_free(sigma_dot_x);
-    return the_result;
+struct apop_mvn_factor {
+    gsl_matrix *cholesky; //lower triangle; zeros above the diagonal.
+    double log_det;
+    int refs;
+};
+
+//Call only inside OMP_critical(mvn_factor). Returns 1 if the caller must free f.
+static int factor_drop(struct apop_mvn_factor *f){ return f && !--f->refs; }
+
+static void factor_free(struct apop_mvn_factor *f){
+    gsl_matrix_free(f->cholesky);
+    free(f);
+}
+
+static void factor_release(struct apop_mvn_factor *f){
+    int last;
+    OMP_critical(mvn_factor)
+    last = factor_drop(f);
+    if (last) factor_free(f);
+}
+
+Apop_settings_init(apop_mvn, )
+
+Apop_settings_copy(apop_mvn,
+    if (in->factored) out->factored = apop_matrix_copy(in->factored);
+    if (out->factor)
+        OMP_critical(mvn_factor)
+        out->factor->refs++;
+)
+
+Apop_settings_free(apop_mvn,
+    gsl_matrix_free(in->factored);
+    factor_release(in->factor);
+)
+
+static int same_matrix(gsl_matrix const *a, gsl_matrix const *b){
+    if (a->size1 != b->size1 || a->size2 != b->size2) return 0;
+    for (size_t i=0; i< a->size1; i++)
+        if (memcmp(a->data + i*a->tda, b->data + i*b->tda, sizeof(double)*a->size2)) return 0;
+    return 1;
+}
+
+static struct apop_mvn_factor *factorize(gsl_matrix const *cov){
+    gsl_matrix *chol = apop_matrix_copy(cov);
+    gsl_error_handler_t *prior_handler = gsl_set_error_handler_off();
+    int status = gsl_linalg_cholesky_decomp(chol);
+    gsl_set_error_handler(prior_handler);
+    if (status){
+        gsl_matrix_free(chol);
+        return NULL;
+    }
+    struct apop_mvn_factor *f = malloc(sizeof(struct apop_mvn_factor));
+    *f = (struct apop_mvn_factor){.cholesky=chol, .refs=1};
+    for (size_t i=0; i< cov->size1; i++){
+        f->log_det += 2*log(gsl_matrix_get(chol, i, i));
+        for (size_t j=i+1; j< cov->size2; j++) //returns upper and lower triangle; we want just one.
+            gsl_matrix_set(chol, i, j, 0);
+    }
+    return f;
 }
 
+/* The log likelihood and the RNG both work from the Cholesky factor of the covariance,
+which is kept in an apop_mvn settings group with a copy of the covariance it factors. It
+is recomputed only when the covariance no longer matches that copy, so repeated calls
+with the same covariance (as in a mixture or an MCMC chain that steps only the mean)
+cost one comparison.
+
+The caller gets its own reference to the factor and must hand it back via
+factor_release; if another thread refactors in the meantime, the old factor lives
+until its last user is done. Returns NULL if the covariance isn't positive definite. */
+static struct apop_mvn_factor *mvn_factor(apop_model *m){
+    gsl_matrix const *cov = m->parameters->matrix;
+    struct apop_mvn_factor *f, *stale = NULL;
+    OMP_critical(mvn_factor)
+    {
+    apop_mvn_settings *ms = Apop_settings_get_group(m, apop_mvn);
+    if (!ms) ms = Apop_model_add_group(m, apop_mvn); //not prepped; see mvn_prep.
+    if (!ms->factored || !same_matrix(ms->factored, cov)){
+        if (factor_drop(ms->factor)) stale = ms->factor;
+        gsl_matrix_free(ms->factored);
+        ms->factored = apop_matrix_copy(cov);
+        ms->factor = factorize(cov);
+    }
+    f = ms->factor;
+    if (f) f->refs++;
+    }
+    if (stale) factor_free(stale);
+    return f;
+}
+
+#define Mvn_block 1024
+
+/* With \f$\Sigma=LL'\f$, \f$(x-\mu)'\Sigma^{-1}(x-\mu) = |L^{-1}(x-\mu)|^2\f$. Center a
+block of rows, solve against \f$L'\f$ for all of them at once via dtrsm, and sum squares. */
 static long double apop_multinormal_ll(apop_data *data, apop_model * m){
     Nullcheck_mpd(data, m, GSL_NAN);
-    double determinant = 0;
-    gsl_matrix* inverse = NULL;
-    int i, dimensions  = data->matrix->size2;
-    gsl_vector* x_minus_mu= gsl_vector_alloc(data->matrix->size2);
-    double ll = 0;
-    determinant = apop_det_and_inv(m->parameters->matrix, &inverse, 1,1);
-    Apop_stopif(isnan(determinant) || determinant == 0,
-        gsl_vector_free(x_minus_mu); return GSL_NEGINF, //tell maximizers to look elsewhere.
-         1, "the determinant of the given covariance is zero or NaN. Returning GSL_NEGINF."); 
-    Apop_stopif(determinant <= 0, return NAN, 0, "The determinant of the covariance matrix you gave me "
-            "is negative, but a covariance matrix must always be positive semidefinite "
-            "(and so have nonnegative determinant). Maybe run apop_matrix_to_positive_semidefinite?");
-    for (i=0; i< data->matrix->size1; i++){
-        gsl_vector_memcpy(x_minus_mu, Apop_rv(data, i));
-        gsl_vector_sub(x_minus_mu, m->parameters->vector);
-        ll += - x_prime_sigma_x(x_minus_mu, inverse) / 2;
+    gsl_matrix const *x = data->matrix;
+    gsl_vector const *mu = m->parameters->vector;
+    size_t dimensions = x->size2;
+    Apop_stopif(m->parameters->matrix->size1 != dimensions || m->parameters->matrix->size2 != dimensions
+            || mu->size != dimensions, return GSL_NAN, 0, "The data has %zu columns, but the "
+            "parameters have a %zu-element mean and a %zu X %zu covariance.", dimensions,
+            mu->size, m->parameters->matrix->size1, m->parameters->matrix->size2);
+    struct apop_mvn_factor *f = mvn_factor(m);
+    if (!f){
+        double determinant = apop_matrix_determinant(m->parameters->matrix);
+        Apop_stopif(determinant < 0, return NAN, 0, "The determinant of the covariance matrix you gave me "
+                "is negative, but a covariance matrix must always be positive semidefinite "
+                "(and so have nonnegative determinant). Maybe run apop_matrix_to_positive_semidefinite?");
+        Apop_notify(1, "the given covariance is singular or not positive definite. Returning GSL_NEGINF.");
+        return GSL_NEGINF; //tell maximizers to look elsewhere.
     }
-    ll -= data->matrix->size1 * (log(2 * M_PI)* dimensions/2. + .5 * log(determinant));
-    gsl_matrix_free(inverse);
-    gsl_vector_free(x_minus_mu);
-    return ll;
+    long double ss = 0;
+    gsl_matrix *centered = gsl_matrix_alloc(GSL_MIN(Mvn_block, x->size1), dimensions);
+    for (size_t start=0; start< x->size1; start+=Mvn_block){
+        size_t rows = GSL_MIN(Mvn_block, x->size1 - start);
+        gsl_matrix *block = Apop_subm(centered, 0, 0, rows, dimensions);
+        for (size_t i=0; i< rows; i++){
+            double const *xrow = x->data + (start+i)*x->tda;
+            double *crow = block->data + i*block->tda;
+            for (size_t j=0; j< dimensions; j++)
+                crow[j] = xrow[j] - gsl_vector_get(mu, j);
+        }
+        gsl_blas_dtrsm(CblasRight, CblasLower, CblasTrans, CblasNonUnit, 1, f->cholesky, block);
+        for (size_t i=0; i< rows; i++){
+            double const *crow = block->data + i*block->tda;
+            for (size_t j=0; j< dimensions; j++) ss += crow[j]*crow[j];
+        }
+    }
+    gsl_matrix_free(centered);
+    double log_det = f->log_det;
+    factor_release(f);
+    return -ss/2 - x->size1 * (log(2 * M_PI)* dimensions/2. + .5 * log_det);
 }
 
 static double a_mean(gsl_vector * in){ return apop_vector_mean(in); }
@@ -61,24 +168,18 @@ static void multivariate_normal_estimate(apop_data * data, apop_model *p){
     apop_data_add_named_elmt(p->info, "log likelihood", apop_multinormal_ll(data, p));
 }
 
-/* \adoc RNG From <a href="http://cgm.cs.mcgill.ca/~luc/mbookindex.html">Devroye (1986)</a>, p 565.  */
+/* \adoc RNG From <a href="http://cgm.cs.mcgill.ca/~luc/mbookindex.html">Devroye (1986)</a>, p 565.
+Uses the same cached Cholesky factor as the log likelihood. */
 static int mvnrng(double *out, gsl_rng *r, apop_model *eps){
     apop_data *params = eps->parameters;
-    gsl_vector *v = gsl_vector_alloc(params->vector->size);
-    gsl_vector *dotted = gsl_vector_calloc(params->vector->size);
-    for (size_t i=0; i< params->vector->size; i++)
-        gsl_vector_set(v, i, gsl_ran_gaussian(r, 1));
-    gsl_matrix *copy  = apop_matrix_copy(params->matrix);
-        gsl_linalg_cholesky_decomp(copy); //returns upper and lower triangle; we want just one.
-    for (size_t i=0; i< copy->size1; i++)
-        for (size_t j=i+1; j< copy->size2; j++)
-            gsl_matrix_set(copy, i, j, 0);
-    gsl_blas_dgemv(CblasNoTrans, 1, copy, v, 0, dotted);
+    struct apop_mvn_factor *f = mvn_factor(eps);
+    Apop_stopif(!f, return 1, 0, "The covariance matrix isn't positive definite, so I can't draw from this model.");
+    gsl_vector_view v = gsl_vector_view_array(out, params->vector->size);
     for (size_t i=0; i< params->vector->size; i++)
-        out[i]  = gsl_vector_get(dotted, i) + gsl_vector_get(params->vector,i);
-    gsl_vector_free(v);
-    gsl_vector_free(dotted);
-    gsl_matrix_free(copy);
+        out[i] = gsl_ran_gaussian(r, 1);
+    gsl_blas_dtrmv(CblasLower, CblasNoTrans, CblasNonUnit, f->cholesky, &v.vector);
+    factor_release(f);
+    gsl_vector_add(&v.vector, params->vector);
     return 0;
 }
 
@@ -86,6 +187,8 @@ static void mvn_prep(apop_data *d, apop_model *m){
     if (d && d->matrix)    m->dsize = d->matrix->size2; 
     else if (m->vsize > 0) m->dsize = m->vsize;
     apop_model_clear(d, m);
+    //Add the cache group now, so log_likelihood and draw never realloc m->settings.
+    if (!Apop_settings_get_group(m, apop_mvn)) Apop_model_add_group(m, apop_mvn);
 }
 
 static long double mvn_constraint(apop_data *d, apop_model *m){
@@ -28,6 +28,7 @@ replace that matrix column with a constant column of ones, just like with OLS.
 #include "apop_internal.h"
 
 static void probit_dlog_likelihood(apop_data *d, gsl_vector *gradient, apop_model *p);
+static void logit_dlog_likelihood(apop_data *d, gsl_vector *gradient, apop_model *p);
 
 static apop_data *get_category_table(apop_data *d){
     int first_col = d->vector ? -1 : 0;
@@ -43,7 +44,7 @@ static void probit_prep(apop_data *d, apop_model *m){
     if (m->data && m->parameters) return; //already prepped; re-prep is a no-op.
     apop_data *factor_list = get_category_table(d);
     apop_score_vtable_add(probit_dlog_likelihood, apop_probit);
-    //apop_score_vtable_add(logit_dlog_likelihood, apop_logit);
+    apop_score_vtable_add(logit_dlog_likelihood, apop_logit);
     apop_ols->prep(d, m);//also runs the default apop_model_clear.
     int count = factor_list->textsize[0];
     m->parameters = apop_data_alloc(d->matrix->size2, count-1);
@@ -80,77 +81,66 @@ static void probit_prep(apop_data *d, apop_model *m){
     sets->starting_pt= params_as_vector->data;
 }
 
-static double biprobit_ll_row(apop_data *r){
-    long double n = gsl_cdf_gaussian_P(-gsl_matrix_get(r->matrix, 0, 0),1);
-    n = n ? n : 1e-10; //prevent -inf in the next step.
-    n = n<1 ? n : 1-1e-10; 
-    return r->vector->data[0] ?  log(1-n): log(n);
+/* Both models start with X\beta for every row and every non-numeraire choice, in one
+   BLAS call. Parameters are (data columns) by (choices-1); the output is (rows) by (choices-1). */
+static gsl_matrix *xbeta(apop_data *d, apop_model *p){
+    gsl_matrix *out = gsl_matrix_alloc(d->matrix->size1, p->parameters->matrix->size2);
+    gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1, d->matrix, p->parameters->matrix, 0, out);
+    return out;
+}
+
+/* The gradient of a sum over rows is X' times the (rows) by (choices-1) matrix of
+   per-row derivatives with respect to x\beta_j. The gradient vector is the parameter
+   matrix packed row by row, so view it as a matrix and let BLAS write there directly. */
+static void gradient_via_blas(apop_data *d, gsl_matrix *dxb, gsl_vector *gradient){
+    gsl_matrix_view g = gsl_matrix_view_vector(gradient, d->matrix->size2, dxb->size2);
+    gsl_blas_dgemm(CblasTrans, CblasNoTrans, 1, d->matrix, dxb, 0, &g.matrix);
 }
 
-//The case where outcome is a single zero/one option.
-static long double biprobit_log_likelihood(apop_data *d, apop_model *p){
-    apop_data *betadotx = apop_dot(d, p->parameters); 
-    betadotx->vector = d->vector;
-    double total_prob = apop_map_sum(betadotx, .fn_r=biprobit_ll_row);
-    betadotx->vector = NULL;
-    apop_data_free(betadotx);
-	return total_prob;
+static apop_data *category_table(apop_data *d, apop_model *p){
+    return get_category_table(p->data ? p->data : d);
 }
 
-static threadlocal double val;
-static double unordered(double in){ return in == val; }
+//The chance of not choosing the option, clamped to prevent -inf in the log.
+static double probit_cdf(double xb){
+    double cdf = gsl_cdf_gaussian_P(-xb, 1);
+    cdf = cdf ? cdf : 1e-10;
+    return cdf<1 ? cdf : 1-1e-10; 
+}
 
-// This is just a for loop that runs a probit on each column.
+/* With two options, this is the usual probit. With more, this runs a probit on each
+   column: option j versus everything else, using column j of the parameters. */
 static long double multiprobit_log_likelihood(apop_data *d, apop_model *p){
     Nullcheck_mpd(d, p, GSL_NAN)
-    gsl_vector *val_vector = get_category_table(d)->vector;
-    if (val_vector->size==2) return biprobit_log_likelihood(d, p);
-    //else, multinomial loop
-    static threadlocal apop_model *spare_probit = NULL;
-    if (!spare_probit){
-        spare_probit = apop_model_copy(apop_probit);
-        spare_probit->parameters = apop_data_alloc();
-    }
-    Staticdef(apop_data *, working_data, apop_data_alloc());
-    working_data->matrix = d->matrix;
-    gsl_vector *original_outcome = d->vector;
-    double ll = 0;
-    double *vals = val_vector->data;
-    for(size_t i=0; i < p->parameters->matrix->size2; i++){
-        val = vals[i];
-        working_data->vector = apop_vector_map(original_outcome, unordered);
-        spare_probit->parameters->matrix = apop_vector_to_matrix(Apop_cv(p->parameters, 1));
-        ll  += apop_log_likelihood(working_data, spare_probit);
-        gsl_vector_free(working_data->vector); //yup. It's inefficient.
-        gsl_matrix_free(spare_probit->parameters->matrix);
+    double *vals = category_table(d, p)->vector->data;
+    gsl_matrix *xb = xbeta(d, p);
+    long double ll = 0;
+    for (size_t i=0; i< xb->size1; i++){
+        double y = gsl_vector_get(d->vector, i);
+        for (size_t j=0; j< xb->size2; j++){
+            double cdf = probit_cdf(gsl_matrix_get(xb, i, j));
+            ll += (y == vals[j+1]) ? log(1-cdf) : log(cdf);
+        }
     }
+    gsl_matrix_free(xb);
 	return ll;
 }
 
 static void probit_dlog_likelihood(apop_data *d, gsl_vector *gradient, apop_model *p){
-    Nullcheck_mp(p, )
-    gsl_vector *val_vector = get_category_table(p->data)->vector;
-    if (val_vector->size!=2){
-        gsl_vector * numeric_default = apop_numerical_gradient(d, p);
-        gsl_vector_memcpy(gradient, numeric_default);
-        gsl_vector_free(numeric_default);
-        return;
+    Nullcheck_mpd(d, p, )
+    double *vals = category_table(d, p)->vector->data;
+    gsl_matrix *xb = xbeta(d, p);
+    for (size_t i=0; i< xb->size1; i++){
+        double y = gsl_vector_get(d->vector, i);
+        for (size_t j=0; j< xb->size2; j++){
+            double *cell = gsl_matrix_ptr(xb, i, j);
+            double cdf = probit_cdf(*cell),
+                   pdf = gsl_ran_gaussian_pdf(-*cell, 1);
+            *cell = (y == vals[j+1]) ? pdf/(1-cdf) : -pdf/cdf;
+        }
     }
-    long double	cdf, betax, deriv_base;
-    apop_data *betadotx = apop_dot(d, p->parameters); 
-    gsl_vector_set_all(gradient, 0);
-    for (size_t i=0; i< d->matrix->size1; i++){
-        betax = apop_data_get(betadotx, i, 0);
-        cdf = gsl_cdf_gaussian_P(-betax, 1);
-        cdf = cdf ? cdf : 1e-10; //prevent -inf in the next step.
-        cdf = cdf<1 ? cdf : 1-1e-10; 
-        deriv_base = apop_data_get(d, i, -1)
-                       ?  gsl_ran_gaussian_pdf(-betax, 1) /(1-cdf)
-                       : -gsl_ran_gaussian_pdf(-betax, 1) / cdf;
-        for (size_t j=0; j< d->matrix->size2; j++)
-            *gsl_vector_ptr(gradient, j) += apop_data_get(d, i, j) * deriv_base;
-	}
-	apop_data_free(betadotx);
+    gradient_via_blas(d, xb, gradient);
+    gsl_matrix_free(xb);
 }
 
 apop_model *apop_probit = &(apop_model){"Probit", .log_likelihood = multiprobit_log_likelihood,
@@ -209,84 +199,50 @@ static size_t find_index(double in, double *m, size_t max){
     return i;
 }
 
-double one_logit_row(apop_data *thisobservation, void *factor_list){
-    //get the $x\beta_j$ numerator for the appropriate choice:
-    size_t index   = find_index(gsl_vector_get(thisobservation->vector, 0), 
-                                factor_list, thisobservation->matrix->size2);
-    Apop_row_v(thisobservation, 0, thisrow);
-    double num = (index==0) ? 0 : gsl_vector_get(thisrow, index-1);
-
-    /* Get the denominator, ln(sum(exp(xbeta))) using the subtract-the-max trick 
-     mentioned in the documentation.  Don't forget the implicit beta_0, fixed at 
-     zero (so we need to add exp(0-max)). */
-
-    double max = gsl_vector_max(thisrow);
-    gsl_vector_add_constant(thisrow, -max);
-    apop_vector_exp(thisrow);
-    //return num - (max + log(apop_vector_sum(thisrow) +exp(-max)));
-    long double expmax = expl(-max);
-    return num - (max + (isfinite(expmax)? logl(apop_vector_sum(thisrow) +  expmax) : -max) );
+/* For one row of x\beta (the numeraire's x\beta_0=0 is implicit), replace each element
+   with the probability of that choice, and return ln(\sum_j e^{x\beta_j}), using the
+   subtract-the-max trick mentioned in the documentation. */
+static double logit_probabilities(double *xb, size_t k){
+    double max = 0; //the numeraire
+    for (size_t j=0; j< k; j++) max = GSL_MAX(max, xb[j]);
+    long double total = expl(-max);
+    for (size_t j=0; j< k; j++) total += (xb[j] = exp(xb[j]-max));
+    for (size_t j=0; j< k; j++) xb[j] /= total;
+    return max + logl(total);
 }
 
 static long double multilogit_log_likelihood(apop_data *d, apop_model *p){
     Nullcheck_mpd(d, p, GSL_NAN)
     Nullcheck(d->matrix, GSL_NAN)
-    //Find X\beta_i for each row of X and each column of \beta.
-    apop_data  *xbeta = apop_dot(d, p->parameters);
-    double* factor_list = get_category_table(p->data)->vector->data;
-    xbeta->vector = d->vector; //we'll need this in one_logit_row
-    long double ll = apop_map_sum(xbeta, .fn_rp = one_logit_row, .param=factor_list);
-    xbeta->vector = NULL;
-    apop_data_free(xbeta);
-	return ll;
-}
-
-/*
-static void dlogit_foreach(apop_data *x, apop_data *gmat, gsl_matrix *beta, apop_data *factor_list){
-  //\beta_this = choice for the row.
-  //dLL/d\beta_ij = [(\beta_i==\beta_this) ? x_j : 0] - x_i e^(x\beta_j)/\sum_k e^(x\beta_k)
-  //that last term simplifies: x / \sum_k e^(x(\beta_k - \beta_i))
-    Apop_row_v(x, 0, xdata);
-    assert(gmat->matrix->size1 == x->matrix->size2);     //the j index---input vars (incl. 1 column)
-    assert(gmat->matrix->size2 == beta->size2); //the i index---choices
-    assert(xdata->size == beta->size1);//cols of data=variables; rows of output=var.s (cols=choices)
-    size_t choice = find_index(gsl_vector_get(x->vector, 0), factor_list->vector->data, factor_list->vector->size);
-    for (int i=0; i < beta->size2; i++) { //go through choices.
-        gsl_vector *denom = gsl_vector_alloc(beta->size1);
-        gsl_vector_set_all(denom, 1); //see below
-        for (int other=-1; other < (int)beta->size2; other++){
-            if (other != i) { //this block calculates exp(x (otherbeta-thisbeta))
-                Apop_matrix_col(beta, i, thisbeta); 
-                gsl_vector *diff = apop_vector_copy(thisbeta);
-                gsl_vector_scale(diff, -1);
-                if (other >=0){//the phantom beta_0 == 0, so that term is e^x(0-beta|i)
-                    Apop_matrix_col(beta, other, otherbeta);
-                    gsl_vector_add(diff, otherbeta);
-                }
-                gsl_vector_mul(diff, xdata);
-                apop_vector_exp(diff);
-                gsl_vector_add(denom, diff);
-                gsl_vector_free(diff);
-            } //else, other==i, and \beta_i - \beta_i = 0, and e^{0x} = 1. Thus the gsl_vector_set_all(denom, 1).
-        }
-        for (int j=0; j< xdata->size; j++){ //add to each coefficient of the gradient matrix 
-            double pick = (choice-1 == i) ? gsl_vector_get(xdata,j) : 0; //numeraire has no betas.
-            *gsl_matrix_ptr(gmat->matrix, j, i) += pick - gsl_vector_get(xdata, j)/gsl_vector_get(denom, j));
-        }
-        gsl_vector_free(denom);
+    apop_data *factors = category_table(d, p);
+    gsl_matrix *xb = xbeta(d, p);
+    size_t k = xb->size2;
+    long double ll = 0;
+    for (size_t i=0; i< xb->size1; i++){
+        double *row = gsl_matrix_ptr(xb, i, 0);
+        size_t choice = find_index(gsl_vector_get(d->vector, i), factors->vector->data, k);
+        ll += (choice ? row[choice-1] : 0) - logit_probabilities(row, k);
     }
+    gsl_matrix_free(xb);
+	return ll;
 }
 
+/* dLL/d\beta_j = \sum_i x_i ([choice_i == j] - P(choice j | x_i)). */
 static void logit_dlog_likelihood(apop_data *d, gsl_vector *gradient, apop_model *p){
-    Nullcheck_mpd(d, p, );
-    apop_data *gradient_matrix = apop_data_calloc(p->parameters->matrix->size1, p->parameters->matrix->size2);
-    apop_data *cats = get_category_table(d);
-    for (int i=0; i< d->matrix->size1; i++)
-        dlogit_foreach(Apop_r(d, i), gradient_matrix, p->parameters->matrix, cats);
-    apop_data_pack(gradient_matrix, gradient);
-    apop_data_free(gradient_matrix);
+    Nullcheck_mpd(d, p, )
+    apop_data *factors = category_table(d, p);
+    gsl_matrix *xb = xbeta(d, p);
+    size_t k = xb->size2;
+    for (size_t i=0; i< xb->size1; i++){
+        double *row = gsl_matrix_ptr(xb, i, 0);
+        size_t choice = find_index(gsl_vector_get(d->vector, i), factors->vector->data, k);
+        logit_probabilities(row, k);
+        for (size_t j=0; j< k; j++) row[j] = -row[j];
+        if (choice) row[choice-1] += 1;
+    }
+    gradient_via_blas(d, xb, gradient);
+    gsl_matrix_free(xb);
 }
-*/
 
 //Should this be available everywhere?
 static size_t get_draw_size(apop_model *in){
@@ -384,5 +340,5 @@ A loop then calculates the customary p-values.
 \include logit.c
 */
 apop_model *apop_logit = &(apop_model){.name="Logit", .log_likelihood = multilogit_log_likelihood, .dsize=-1,
-/*.score = logit_dlog_likelihood,*/ .prep = logit_prep, .draw=logit_rng
+.prep = logit_prep, .draw=logit_rng
 };
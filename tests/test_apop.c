@@ -122,6 +122,29 @@ void test_percentiles(){
     assert(pcts_up[100] == pcts_down[100] && pcts_avg[100] == pcts_down[100]);
     assert(pcts_up[0] == pcts_down[0] && pcts_avg[0] == pcts_down[0]);
     assert(pcts_avg[50] == (pcts_down[50] + pcts_up[50])/2);
+
+    //Selection should give exactly what reading off a sorted copy gives, ties and all.
+    gsl_rng *r = apop_rng_alloc(43);
+    for (size_t n=1; n< 3000; n = n*3+1){
+        gsl_vector *x = gsl_vector_alloc(n), *sorted = gsl_vector_alloc(n);
+        for (size_t i=0; i< n; i++) gsl_vector_set(x, i, (i%2) ? gsl_rng_uniform(r) : gsl_rng_uniform_int(r, 4));
+        gsl_vector_memcpy(sorted, x);
+        gsl_sort_vector(sorted);
+        for (char *round="uda"; *round; round++){
+            double *p = apop_vector_percentiles(x, *round);
+            for (int i=0; i< 101; i++){
+                size_t index = i*(n-1)/100.0;
+                int is_exact = (index == i*(n-1)/100.0);
+                if (*round == 'u' && !is_exact) index++;
+                assert(p[i] == ((*round == 'a' && !is_exact)
+                                ? (gsl_vector_get(sorted, index) + gsl_vector_get(sorted, index+1))/2.
+                                : gsl_vector_get(sorted, index)));
+            }
+            free(p);
+        }
+        gsl_vector_free(x); gsl_vector_free(sorted);
+    }
+    gsl_rng_free(r);
 }
 
 void test_score(){
@@ -294,6 +317,252 @@ void test_weigted_moments(){
     wmt(v, v2, w2, av, av2, 1);
 }
 
+/* Inputs that defeat naive summation and the E(x^2)-E^2(x) form of the variance: a large
+offset on small deviations, and alternating terms that cancel. */
+void test_ill_conditioned_moments(){
+    int reps = 2501;
+    gsl_vector *v = gsl_vector_alloc(4*reps);
+    gsl_vector *w = gsl_vector_alloc(4*reps);
+    gsl_vector_set_all(w, 2);
+    double devs[] = {4, 7, 13, 16};
+    for (int i=0; i< 4*reps; i++) gsl_vector_set(v, i, 1e9 + devs[i%4]);
+    double m2 = 90.*reps; //mean is 1e9+10; squared deviations sum to 90 per rep.
+    Diff(apop_vector_mean(v), 1e9+10, 1e-6);
+    Diff(apop_vector_var(v), m2/(4*reps-1), 1e-9);
+    Diff(apop_vector_var(v, w), 2*m2/(8*reps-1), 1e-9);
+    Diff(apop_vector_mean(v, w), 1e9+10, 1e-6);
+
+    //a column view of a matrix, to check the strided path.
+    gsl_matrix *m = gsl_matrix_alloc(4*reps, 3);
+    gsl_matrix_set_all(m, -1);
+    gsl_vector_memcpy(Apop_mcv(m, 1), v);
+    Diff(apop_vector_var(Apop_mcv(m, 1)), m2/(4*reps-1), 1e-9);
+    Diff(apop_vector_var(Apop_mcv(m, 1), w), 2*m2/(8*reps-1), 1e-9);
+    double mean, var;
+    apop_matrix_mean_and_var(Apop_subm(m, 0, 1, 4*reps, 1), &mean, &var);
+    Diff(mean, 1e9+10, 1e-6);
+    Diff(var, m2/(4*reps), 1e-9);
+
+    //The covariance uses the same centered kernel and the same reading of the weights.
+    gsl_vector *wn = gsl_vector_alloc(4*reps);
+    for (int i=0; i< 4*reps; i++) gsl_vector_set(wn, i, (1 + i%3)/(8.*reps));
+    assert(apop_vector_cov(v, v, wn) == apop_vector_var(v, wn));
+    assert(apop_vector_cov(v, v, w) == apop_vector_var(v, w));
+    assert(apop_vector_cov(v, v) == apop_vector_var(v));
+    Diff(apop_vector_cov(v, Apop_mcv(m, 1), w), 2*m2/(8*reps-1), 1e-9); //large offset, strided
+    Diff(apop_vector_cov(v, Apop_mcv(m, 1), wn), apop_vector_var(v, wn), 1e-9);
+    gsl_vector_free(wn);
+
+    //1e100, 1, -1e100, ...: each one survives only if the big terms are compensated.
+    for (int i=0; i< 3*reps; i++) gsl_vector_set(v, i, (double[]){1e100, 1, -1e100}[i%3]);
+    assert(apop_vector_sum(Apop_subvector(v, 0, 3*reps)) == reps);
+    for (int i=0; i< 3*reps; i++) gsl_matrix_set(m, i, 2, gsl_vector_get(v, i));
+    assert(apop_vector_sum(Apop_subvector(Apop_mcv(m, 2), 0, 3*reps)) == reps);
+    gsl_matrix_free(m);
+    gsl_vector_free(v);
+    gsl_vector_free(w);
+}
+
+/* The rank-k covariance against pairwise apop_vector_cov, and weights against replicated rows. */
+void test_covariance_matrix(gsl_rng *r){
+    size_t n = 1300, k = 5; //more than one block of rows.
+    apop_data *d = apop_data_alloc(n, k);
+    for (size_t i=0; i< n; i++)
+        for (size_t j=0; j< k; j++)
+            apop_data_set(d, i, j, gsl_rng_uniform(r)*(j+1) + (j==2 ? apop_data_get(d, i, 0) : 0));
+    apop_name_add(d->names, "a", 'c');
+    apop_name_add(d->names, "b", 'c');
+    apop_data *cov = apop_data_covariance(d);
+    for (size_t i=0; i< k; i++)
+        for (size_t j=0; j< k; j++)
+            Diff(apop_data_get(cov, i, j), apop_vector_cov(Apop_cv(d, i), Apop_cv(d, j)), 1e-12);
+    assert(!strcmp(cov->names->col[1], "b") && !strcmp(cov->names->row[0], "a"));
+
+    apop_data *corr = apop_data_correlation(d);
+    for (size_t i=0; i< k; i++){
+        Diff(apop_data_get(corr, i, i), 1, 1e-12);
+        Diff(apop_data_get(corr, i, 2), apop_vector_correlation(Apop_cv(d, i), Apop_cv(d, 2)), 1e-12);
+    }
+
+    //weights of 1, 2, 3 give the same covariance as one, two, or three copies of each row.
+    d->weights = gsl_vector_alloc(n);
+    size_t total = 0;
+    for (size_t i=0; i< n; i++) total += (d->weights->data[i] = i%3 + 1);
+    apop_data *rep = apop_data_alloc(total, k);
+    for (size_t i=0, row=0; i< n; i++)
+        for (int c=0; c< i%3+1; c++, row++)
+            gsl_vector_memcpy(Apop_rv(rep, row), Apop_rv(d, i));
+    apop_data *wcov = apop_data_covariance(d);
+    apop_data *repcov = apop_data_covariance(rep);
+    for (size_t i=0; i< k; i++)
+        for (size_t j=0; j< k; j++)
+            Diff(apop_data_get(wcov, i, j), apop_data_get(repcov, i, j), 1e-12);
+    apop_data_free(d); apop_data_free(rep);
+    apop_data_free(cov); apop_data_free(corr);
+    apop_data_free(wcov); apop_data_free(repcov);
+}
+
+/* Feed a data set in uneven chunks to two accumulators, merge, and compare to the in-memory functions. */
+void test_accumulators(gsl_rng *r){
+    size_t n = 1700, k = 3;
+    apop_data *d = apop_data_alloc(n, k);
+    d->weights = gsl_vector_alloc(n);
+    for (size_t i=0; i< n; i++){
+        for (size_t j=0; j< k; j++) apop_data_set(d, i, j, gsl_ran_exponential(r, j+1) + 100*j);
+        gsl_vector_set(d->weights, i, i%4);
+    }
+    apop_name_add(d->names, "x", 'c');
+    apop_name_add(d->names, "y", 'c');
+    apop_name_add(d->names, "z", 'c');
+    for (int weighted=0; weighted< 2; weighted++){
+        gsl_vector *w = weighted ? d->weights : NULL;
+        apop_accumulator *a = apop_accumulator_alloc(k), *b = apop_accumulator_alloc(k);
+        size_t cuts[] = {0, 3, 600, 601, 1500, n};
+        for (int c=0; c< 5; c++){
+            apop_data *chunk = Apop_rs(d, cuts[c], cuts[c+1]-cuts[c]);
+            if (!weighted) chunk->weights = NULL;
+            assert(!apop_accumulator_add(c%2 ? a : b, chunk));
+        }
+        assert(!apop_accumulator_merge(a, b));
+        apop_data *sum = apop_accumulator_summarize(a);
+        for (size_t j=0; j< k; j++){
+            gsl_vector *col = Apop_cv(d, j);
+            Diff(apop_data_get(sum, j, .colname="mean"), apop_vector_mean(col, w), 1e-9);
+            Diff(apop_data_get(sum, j, .colname="variance"), apop_vector_var(col, w), 1e-9);
+            Diff(apop_data_get(sum, j, .colname="skew"), apop_vector_skew_pop(col, w), 1e-8);
+            Diff(apop_data_get(sum, j, .colname="kurtosis"), apop_vector_kurtosis_pop(col, w), 1e-7);
+            assert(apop_data_get(sum, j, .colname="min") == gsl_vector_min(col));
+            assert(apop_data_get(sum, j, .colname="max") == gsl_vector_max(col));
+        }
+        assert(!strcmp(sum->names->row[2], "z"));
+        apop_data *cov = apop_accumulator_covariance(a);
+        apop_data *full = apop_data_covariance(&(apop_data){.matrix=d->matrix, .weights=w});
+        for (size_t i=0; i< k; i++)
+            for (size_t j=0; j< k; j++)
+                Diff(apop_data_get(cov, i, j), apop_data_get(full, i, j), 1e-9);
+        apop_data_free(sum); apop_data_free(cov); apop_data_free(full);
+        apop_accumulator_free(a); apop_accumulator_free(b);
+    }
+    apop_accumulator *wrong = apop_accumulator_alloc(2);
+    apop_opts.verbose --;
+    assert(apop_accumulator_add(wrong, d));
+    apop_opts.verbose ++;
+    apop_accumulator_free(wrong);
+    apop_data_free(d);
+}
+
+/* The t-digest's percentiles, fed in two merged halves, should be within a percent (in
+rank) of the exact ones; the extremes are exact. The SQL aggregates use the same sketch. */
+void test_tdigest(gsl_rng *r){
+    size_t n = 20000;
+    gsl_vector *v = gsl_vector_alloc(n);
+    for (size_t i=0; i< n; i++) gsl_vector_set(v, i, gsl_ran_exponential(r, 2));
+    apop_tdigest *t = apop_tdigest_alloc(100), *t2 = apop_tdigest_alloc(100);
+    apop_tdigest_add_vector(t, Apop_subvector(v, 0, n/2), NULL);
+    apop_tdigest_add_vector(t2, Apop_subvector(v, n/2, n-n/2), NULL);
+    apop_tdigest_merge(t, t2);
+    assert(t->total_weight == n);
+    assert(t->centroid_ct + t->unmerged_ct < 6*100+10);
+
+    double *exact = apop_vector_percentiles(v, 'a');
+    double *approx = apop_tdigest_percentiles(t);
+    assert(approx[0] == exact[0] && approx[100] == exact[100]);
+    for (int i=1; i< 100; i++){
+        Diff(apop_tdigest_cdf(t, exact[i]), i/100., 0.01);
+        assert(approx[i] >= approx[i-1]);
+    }
+    Diff(apop_tdigest_cdf(t, apop_tdigest_median(t)), 0.5, 1e-3);
+    assert(apop_tdigest_cdf(t, exact[0]-1) == 0 && apop_tdigest_cdf(t, exact[100]) == 1);
+
+    //weight 3 on every element is the same distribution.
+    apop_tdigest *tw = apop_tdigest_alloc(100);
+    gsl_vector *w = gsl_vector_alloc(n);
+    gsl_vector_set_all(w, 3);
+    apop_tdigest_add_vector(tw, v, w);
+    Diff(apop_tdigest_quantile(tw, 0.3), exact[30], 0.05);
+
+    if (apop_opts.db_engine=='s'){
+        apop_table_exists(.remove='d', .name="td_t");
+        apop_query("create table td_t(vals)");
+        apop_query("begin");
+        for (size_t i=0; i< n; i++) apop_query("insert into td_t values(%.17g)", gsl_vector_get(v, i));
+        apop_query("insert into td_t values(null)");
+        apop_query("commit");
+        apop_tdigest *tq = apop_tdigest_alloc(100);
+        assert(!apop_tdigest_add_query(tq, "select vals from td_t"));
+        assert(tq->total_weight == n);
+        Diff(apop_tdigest_cdf(tq, apop_query_to_float("select median(vals) from td_t")), 0.5, 0.01);
+        Diff(apop_tdigest_cdf(tq, apop_query_to_float("select quantile(vals, .9) from td_t")), 0.9, 0.01);
+        assert(apop_query_to_float("select quantile(vals, 1) from td_t") == exact[100]);
+        apop_table_exists("td_t", 'd');
+        apop_tdigest_free(tq);
+    }
+    free(exact); free(approx);
+    gsl_vector_free(v); gsl_vector_free(w);
+    apop_tdigest_free(t); apop_tdigest_free(t2); apop_tdigest_free(tw);
+}
+
+/* Each metric of the distance matrix against a direct calculation, for one set (symmetric,
+more than one tile) and for two sets of different sizes. */
+void test_distance_matrix(gsl_rng *r){
+    size_t n = 300, n2 = 7, k = 4;
+    apop_data *a = apop_data_alloc(n, k), *b = apop_data_alloc(n2, k);
+    for (size_t i=0; i< n*k; i++) a->matrix->data[i] = gsl_ran_gaussian(r, 1) + (i%k);
+    for (size_t i=0; i< n2*k; i++) b->matrix->data[i] = gsl_ran_gaussian(r, 2);
+    apop_name_add(b->names, "first", 'r');
+
+    apop_data *e = apop_data_distance_matrix(a);
+    apop_data *m = apop_data_distance_matrix(a, .metric='m');
+    apop_data *g = apop_data_distance_matrix(a, .metric='g', .bandwidth=3);
+    for (size_t i=0; i< n; i+=7)
+        for (size_t j=0; j< n; j+=5){
+            double d = apop_vector_distance(Apop_rv(a, i), Apop_rv(a, j));
+            Diff(apop_data_get(e, i, j), d, 1e-6);
+            Diff(apop_data_get(m, i, j), apop_vector_distance(Apop_rv(a, i), Apop_rv(a, j), .metric='m'), 1e-10);
+            Diff(apop_data_get(g, i, j), exp(-d*d/18), 1e-10);
+            assert(apop_data_get(e, i, j) == apop_data_get(e, j, i));
+        }
+    assert(apop_data_get(e, 11, 11) == 0 && apop_data_get(g, 11, 11) == 1);
+
+    //Mahalanobis with the identity is Euclidean; with a diagonal covariance, it rescales.
+    apop_data *ident = apop_data_calloc(k, k);
+    for (size_t i=0; i< k; i++) apop_data_set(ident, i, i, (i==2) ? 4 : 1);
+    apop_data *h = apop_data_distance_matrix(a, b, .metric='h', .covariance=ident);
+    apop_data *c = apop_data_distance_matrix(a, b, .metric='c');
+    assert(h->matrix->size1 == n && h->matrix->size2 == n2);
+    assert(!strcmp(h->names->col[0], "first"));
+    for (size_t i=0; i< n; i+=3)
+        for (size_t j=0; j< n2; j++){
+            double sq = 0, dot = 0, na = 0, nb = 0;
+            for (size_t l=0; l< k; l++){
+                double x = apop_data_get(a, i, l), y = apop_data_get(b, j, l);
+                sq += gsl_pow_2(x-y)/apop_data_get(ident, l, l);
+                dot += x*y; na += x*x; nb += y*y;
+            }
+            Diff(apop_data_get(h, i, j), sqrt(sq), 1e-6);
+            Diff(apop_data_get(c, i, j), 1 - dot/sqrt(na*nb), 1e-10);
+        }
+
+    apop_opts.verbose --;
+    gsl_matrix_set_all(ident->matrix, 1); //singular
+    apop_data *bad = apop_data_distance_matrix(a, b, .metric='h', .covariance=ident);
+    apop_opts.verbose ++;
+    assert(bad->error == 'm');
+    assert(gsl_isnan(apop_data_get(bad, 0, 0)));
+    apop_data_free(bad);
+
+    apop_data *wrong_size = apop_data_calloc(a->matrix->size2+1, a->matrix->size2+1);
+    apop_opts.verbose --;
+    bad = apop_data_distance_matrix(a, b, .metric='h', .covariance=wrong_size);
+    apop_opts.verbose ++;
+    assert(bad->error == 'd');
+    assert(gsl_isnan(apop_data_get(bad, 0, 0)));
+    apop_data_free(wrong_size);
+    apop_data_free(a); apop_data_free(b); apop_data_free(e); apop_data_free(m);
+    apop_data_free(g); apop_data_free(h); apop_data_free(c); apop_data_free(ident);
+    apop_data_free(bad);
+}
+
 void test_split_and_stack(gsl_rng *r){
     apop_data *d1 = apop_data_alloc(10,10,10);
     int i,j, tr, tc;
@@ -522,6 +791,156 @@ void test_summarize(){
     double v = sqrt((2*2 +3*3 +3*3 +4.*4.)/3.);
     assert (t == v);
     apop_data_free(s);
+
+    //A wide data set, over several pages, one with weights and one without a matrix.
+    gsl_rng *r = apop_rng_alloc(23);
+    apop_data *wide = apop_data_alloc(301, 200);
+    apop_data *info = apop_data_add_page(wide, apop_data_alloc(3), "<info>");
+    apop_data *weighted = apop_data_add_page(wide, apop_data_alloc(0, 50, 7), "weighted");
+    weighted->weights = gsl_vector_alloc(50);
+    for (int i=0; i< 50; i++) gsl_vector_set(weighted->weights, i, gsl_rng_uniform(r));
+    for (apop_data *p = wide; p; p = p->more)
+        if (p->matrix) for (int i=0; i< p->matrix->size1; i++)
+            for (int j=0; j< p->matrix->size2; j++)
+                gsl_matrix_set(p->matrix, i, j, gsl_ran_gaussian(r, j+1) + j);
+    apop_data *sums = apop_data_summarize(wide, .all_pages='y');
+    assert(sums->matrix->size1 == 200 && sums->more && sums->more->matrix->size1 == 7 && !sums->more->more);
+    for (apop_data *p = wide, *sp = sums; p; p = p->more){
+        if (p == info) continue;
+        for (int j=0; j< p->matrix->size2; j++){
+            gsl_vector *col = Apop_cv(p, j);
+            double *pcts = apop_vector_percentiles(col);
+            Diff(apop_data_get(sp, j, .colname="mean"), apop_vector_mean(col, p->weights), 1e-10);
+            Diff(apop_data_get(sp, j, .colname="variance"), apop_vector_var(col, p->weights), 1e-10);
+            assert(apop_data_get(sp, j, .colname="min") == pcts[0]);
+            assert(apop_data_get(sp, j, .colname="median") == pcts[50]);
+            assert(apop_data_get(sp, j, .colname="max") == pcts[100]);
+            free(pcts);
+        }
+        sp = sp->more;
+    }
+    apop_data_free(sums);
+    sums = apop_data_summarize(wide);
+    assert(!sums->more);
+    apop_data_free(sums);
+
+    weighted->weights = apop_vector_realloc(weighted->weights, 49);
+    apop_opts.verbose --;
+    sums = apop_data_summarize(weighted);
+    apop_opts.verbose ++;
+    assert(sums->error == 'd');
+    apop_data_free(sums);
+    apop_data_free(wide);
+    gsl_rng_free(r);
+}
+
+//apop_dot_into should match apop_dot, scaled and accumulated.
+void test_dot_into(gsl_rng *r){
+    apop_data *a = apop_data_alloc(4, 5, 3), *b = apop_data_alloc(5, 5, 2);
+    for (apop_data *d = a; d; d = (d == a ? b : NULL)){
+        for (int i=0; i< d->vector->size; i++) gsl_vector_set(d->vector, i, gsl_rng_uniform(r));
+        for (int i=0; i< d->matrix->size1; i++)
+            for (int j=0; j< d->matrix->size2; j++)
+                apop_data_set(d, i, j, gsl_ran_gaussian(r, 1));
+    }
+    apop_data *fresh = apop_dot(a, b, .form1='t');  //(3x5)(5x2) = 3x2
+    apop_data *into = apop_data_alloc(3, 2);
+    gsl_matrix_set_all(into->matrix, 7);
+    assert(!apop_dot_into(a, b, into, .form1='t', .alpha=2, .beta=.5));
+    for (int i=0; i< 3; i++)
+        for (int j=0; j< 2; j++)
+            Diff(apop_data_get(into, i, j), 2*apop_data_get(fresh, i, j) + 3.5, 1e-12);
+    apop_data_free(fresh);
+
+    //matrix dot vector, vector dot matrix, vector dot vector.
+    apop_data *v2 = apop_data_alloc(2), *v1 = apop_data_alloc(1);
+    fresh = apop_dot(a, b, .form1='v', .form2='v');
+    apop_opts.verbose --;
+    assert(fresh->error == 'd');  //a's vector has 4 elements, b's has 5.
+    apop_data_free(fresh);
+    fresh = apop_dot(b, a, .form1='t', .form2='v'); //(2x5)(4) is mismatched, too.
+    assert(fresh->error == 'd');
+    assert(apop_dot_into(b, a, v2, .form1='t', .form2='v') == 'd' && v2->error == 'd');
+    assert(apop_dot_into(a, b, v2, .form1='t') == 'd'); //a matrix product has nowhere to go
+    apop_opts.verbose ++;
+    apop_data_free(fresh);
+    v2->error = 0;
+
+    apop_data *b_vec = &(apop_data){.vector=b->vector};
+    fresh = apop_dot(b_vec, b, .form2='v');
+    assert(!apop_dot_into(b_vec, b, v1, .form2='v'));
+    assert(apop_data_get(v1) == apop_data_get(fresh));
+    apop_data_free(fresh);
+
+    fresh = apop_dot(b, b_vec, .form1='t', .form2='v'); //5x2' dot 5 = 2
+    gsl_vector_set_all(v2->vector, 1);
+    assert(!apop_dot_into(b, b_vec, v2, .form1='t', .form2='v', .beta=-1));
+    for (int i=0; i< 2; i++) Diff(gsl_vector_get(v2->vector, i), gsl_vector_get(fresh->vector, i) - 1, 1e-12);
+    apop_data_free(fresh);
+
+    fresh = apop_dot(b_vec, b); //5 dot 5x2 = 2
+    assert(!apop_dot_into(b_vec, b, v2));
+    for (int i=0; i< 2; i++) assert(gsl_vector_get(v2->vector, i) == gsl_vector_get(fresh->vector, i));
+    apop_data_free(fresh);
+
+    //Inversion into an existing matrix, and in place.
+    apop_data *sq = apop_dot(a, a, .form1='t');
+    gsl_matrix *inv = apop_matrix_inverse(sq->matrix);
+    double det, det_before = apop_matrix_determinant(sq->matrix);
+    assert(!apop_matrix_inverse_into(sq->matrix, sq->matrix, &det));
+    Diff(det, det_before, 1e-10*fabs(det_before));
+    for (int i=0; i< 3; i++)
+        for (int j=0; j< 3; j++)
+            Diff(apop_data_get(sq, i, j), gsl_matrix_get(inv, i, j), 1e-10);
+    apop_opts.verbose --;
+    assert(apop_matrix_inverse_into(a->matrix, inv, NULL)); //not square
+    apop_opts.verbose ++;
+    gsl_matrix_free(inv);
+    apop_data_free(sq); apop_data_free(v2); apop_data_free(v1);
+    apop_data_free(a); apop_data_free(b); apop_data_free(into);
+}
+
+//Data with a few strong, well-separated components plus noise: the randomized PCA
+//should find the same leading components and eigenvalues as the exact one.
+void test_randomized_pca(gsl_rng *r){
+    size_t n = 2000, k = 80, factors = 4;
+    double scales[] = {10, 6, 3, 1.5};
+    apop_data *loadings = apop_data_alloc(factors, k);
+    for (size_t i=0; i< factors; i++)
+        for (size_t j=0; j< k; j++)
+            apop_data_set(loadings, i, j, gsl_ran_gaussian(r, 1));
+    gsl_matrix *x = gsl_matrix_alloc(n, k);
+    for (size_t i=0; i< n; i++)
+        for (size_t j=0; j< k; j++){
+            double val = gsl_ran_gaussian(r, .3) + 7;
+            for (size_t f=0; f< factors; f++)
+                val += scales[f] * gsl_ran_gaussian(r, 1) * apop_data_get(loadings, f, j) / sqrt(k);
+            gsl_matrix_set(x, i, j, val);
+        }
+    apop_data *cov = apop_data_covariance(&(apop_data){.matrix=x});
+    double trace = 0;
+    for (size_t j=0; j< k; j++) trace += apop_data_get(cov, j, j);
+
+    apop_data *exact = apop_matrix_pca(x);
+    apop_data *fast = apop_matrix_pca(x, factors, .method='r', .rng=r);
+    apop_data *exact_evals = apop_data_get_page(exact, "<Eigenvalues>");
+    apop_data *fast_evals = apop_data_get_page(fast, "<Eigenvalues>");
+    Diff(apop_vector_sum(exact_evals->vector), trace, 1e-6*trace);
+    Diff(apop_vector_sum(exact->vector), 1, 1e-8);
+    assert(fast->matrix->size1 == k && fast->matrix->size2 == factors && fast->vector->size == factors);
+    for (size_t i=0; i< factors; i++){
+        double dot;
+        gsl_blas_ddot(Apop_cv(exact, i), Apop_cv(fast, i), &dot);
+        Diff(fabs(dot), 1, 1e-4); //eigenvectors are only defined up to sign
+        Diff(gsl_vector_get(fast->vector, i), gsl_vector_get(exact->vector, i), 1e-4);
+        Diff(gsl_vector_get(fast_evals->vector, i), gsl_vector_get(exact_evals->vector, i),
+                                                1e-4*gsl_vector_get(exact_evals->vector, i));
+    }
+    apop_data_free(exact);
+    apop_data_free(fast);
+    apop_data_free(cov);
+    apop_data_free(loadings);
+    gsl_matrix_free(x);
 }
 
 void test_dot(){
@@ -771,6 +1190,89 @@ void test_multivariate_normal(){
     apop_data_free(rdraws);
 }
 
+//The log likelihood, found one row at a time with an explicit inverse and determinant.
+static double mvn_ll_by_hand(apop_data *d, apop_data *params){
+    gsl_matrix *inv;
+    double det = apop_det_and_inv(params->matrix, &inv, 1, 1), ll = 0;
+    gsl_vector *dev = gsl_vector_alloc(d->matrix->size2);
+    gsl_vector *invdev = gsl_vector_alloc(d->matrix->size2);
+    for (int i=0; i< d->matrix->size1; i++){
+        gsl_vector_memcpy(dev, Apop_rv(d, i));
+        gsl_vector_sub(dev, params->vector);
+        gsl_blas_dgemv(CblasNoTrans, 1, inv, dev, 0, invdev);
+        double q;
+        gsl_blas_ddot(dev, invdev, &q);
+        ll += -q/2 - log(2*M_PI)*d->matrix->size2/2. - log(det)/2;
+    }
+    gsl_matrix_free(inv);
+    gsl_vector_free(dev);
+    gsl_vector_free(invdev);
+    return ll;
+}
+
+//A multivariate model with no draw method falls back to MCMC, one chain per thread.
+void test_parallel_mcmc_draws(){
+    double params[] = {1,  1, .5,
+                       -2, .5, 2};
+    apop_model *mv = apop_model_copy(apop_multivariate_normal);
+    mv->parameters = apop_data_fill_base(apop_data_alloc(2, 2, 2), params);
+    mv->dsize = 2;
+    mv->draw = NULL;
+    apop_data *d = apop_model_draws(mv, .count=20000);
+    apop_data *cov = apop_data_covariance(d);
+    Diff(apop_vector_mean(Apop_cv(d, 0)), 1, 2e-1);
+    Diff(apop_vector_mean(Apop_cv(d, 1)), -2, 2e-1);
+    Diff(apop_data_get(cov, 0, 0), 1, 3e-1);
+    Diff(apop_data_get(cov, 0, 1), .5, 3e-1);
+    Diff(apop_data_get(cov, 1, 1), 2, 5e-1);
+    assert(mv->parameters->vector->data[0] == 1); //the chains never touch the shared model.
+    apop_data_free(cov);
+    apop_data_free(d);
+    apop_model_free(mv);
+}
+
+void test_mvn_cached_factor(){
+    double params[] = {1,  4, 1, .5,
+                       -2, 1, 3, .2,
+                       0, .5, .2, 2};
+    apop_data *p = apop_data_fill_base(apop_data_alloc(3, 3, 3), params);
+    apop_model *mv = apop_model_copy(apop_multivariate_normal);
+    mv->parameters = p;
+    mv->dsize = 3;
+    apop_data *d = apop_model_draws(mv, .count=3000);
+    Diff(apop_log_likelihood(d, mv), mvn_ll_by_hand(d, p), 1e-6);
+    Diff(apop_log_likelihood(d, mv), mvn_ll_by_hand(d, p), 1e-6); //now from the cache
+
+    //Changing the covariance in place invalidates the cached factor; changing the mean needn't.
+    apop_data_set(p, 0, 0, 5);
+    Diff(apop_log_likelihood(d, mv), mvn_ll_by_hand(d, p), 1e-6);
+    gsl_vector_set(p->vector, 1, 0);
+    Diff(apop_log_likelihood(d, mv), mvn_ll_by_hand(d, p), 1e-6);
+
+    //A copy shares the factor until its own covariance changes; either may be freed first.
+    apop_model *cp = apop_model_copy(mv);
+    Diff(apop_log_likelihood(d, cp), mvn_ll_by_hand(d, p), 1e-6);
+    apop_data_set(cp->parameters, 1, 1, 4);
+    Diff(apop_log_likelihood(d, cp), mvn_ll_by_hand(d, cp->parameters), 1e-6);
+    apop_model_free(cp);
+    Diff(apop_log_likelihood(d, mv), mvn_ll_by_hand(d, p), 1e-6);
+
+    //Threads evaluating one model at once each hold a whole factor.
+    double lls[8];
+    #pragma omp parallel for
+    for (int i=0; i< 8; i++) lls[i] = apop_log_likelihood(d, mv);
+    for (int i=0; i< 8; i++) assert(lls[i] == lls[0]);
+    Diff(lls[0], mvn_ll_by_hand(d, p), 1e-6);
+
+    //Singular covariance: -inf, so maximizers look elsewhere.
+    apop_opts.verbose --;
+    gsl_matrix_set_all(p->matrix, 1);
+    assert(apop_log_likelihood(d, mv) == GSL_NEGINF);
+    apop_opts.verbose ++;
+    apop_data_free(d);
+    apop_model_free(mv);
+}
+
 static void common_binomial_bit(apop_model *out, int n, double p){
     /*double phat = apop_data_get(out->parameters, 1,-1);
     double nhat = apop_data_get(out->parameters, 0,-1);
@@ -870,6 +1372,72 @@ void test_vector_moving_average(){
         assert(gsl_vector_get(v, i+1) == gsl_vector_get(slightly_smooth, i));
 }
 
+//Check each rolling statistic against the same statistic of each window, found directly.
+void test_vector_rolling(gsl_rng *r){
+    size_t n = 200;
+    gsl_vector *v = gsl_vector_alloc(n), *v2 = gsl_vector_alloc(n);
+    for (size_t i=0; i< n; i++){
+        gsl_vector_set(v, i, gsl_rng_uniform_int(r, 20) + gsl_rng_uniform(r));
+        gsl_vector_set(v2, i, gsl_rng_uniform(r));
+    }
+    char *stats = "mvsnxdq", aligns[] = "tc", edges[] = "npt";
+    size_t windows[] = {1, 2, 7, 10};
+    for (int w=0; w< 4; w++) for (char *s=stats; *s; s++) for (int a=0; a< 2; a++) for (int e=0; e< 3; e++){
+        size_t W = windows[w];
+        gsl_vector *out = apop_vector_rolling(v, W, *s, .q=0.3, .align=aligns[a], .edge=edges[e]);
+        gsl_vector *cov = apop_vector_rolling_cov(v, v2, W, .align=aligns[a], .edge=edges[e]);
+        assert(out->size == (edges[e]=='t' ? n-W+1 : n));
+        size_t outpos = 0;
+        for (size_t i=0; i< n; i++){
+            int lo = aligns[a]=='c' ? (int)i - (int)W/2 : (int)i - (int)W + 1, hi = lo + W;
+            int full = lo >= 0 && hi <= n;
+            if (edges[e]=='t' && !full) continue;
+            if (edges[e]=='n' && !full){
+                assert(isnan(gsl_vector_get(out, outpos)));
+                outpos++;
+                continue;
+            }
+            lo = GSL_MAX(lo, 0); hi = GSL_MIN(hi, n);
+            gsl_vector *win = apop_vector_copy(Apop_subvector(v, lo, hi-lo));
+            double expected;
+            if (*s=='m') expected = apop_mean(win);
+            else if (*s=='v') expected = hi-lo > 1 ? apop_var(win) : GSL_NAN;
+            else if (*s=='s') expected = hi-lo > 1 ? sqrt(apop_var(win)) : GSL_NAN;
+            else if (*s=='n') expected = gsl_vector_min(win);
+            else if (*s=='x') expected = gsl_vector_max(win);
+            else {
+                gsl_sort_vector(win);
+                double rank = (*s=='d' ? 0.5 : 0.3) * (hi-lo-1);
+                int k = rank;
+                expected = rank == k ? gsl_vector_get(win, k)
+                                     : (gsl_vector_get(win, k) + gsl_vector_get(win, k+1))/2;
+            }
+            if (isnan(expected)) assert(isnan(gsl_vector_get(out, outpos)));
+            else Diff(gsl_vector_get(out, outpos), expected, 1e-8);
+            if (hi-lo > 1 && *s=='m')
+                Diff(gsl_vector_get(cov, outpos), apop_vector_cov(Apop_subvector(v, lo, hi-lo),
+                                                    Apop_subvector(v2, lo, hi-lo)), 1e-8);
+            gsl_vector_free(win);
+            outpos++;
+        }
+        gsl_vector_free(out);
+        gsl_vector_free(cov);
+    }
+
+    //A NaN spoils every window it is in, and no others.
+    gsl_vector_set(v, 50, GSL_NAN);
+    gsl_vector *med = apop_vector_rolling(v, 5, 'd');
+    for (size_t i=4; i< n; i++)
+        assert(!!isnan(gsl_vector_get(med, i)) == (i >= 50 && i < 55));
+    gsl_vector_free(med);
+
+    apop_opts.verbose --;
+    assert(!apop_vector_rolling(v, n+1, .edge='t'));
+    apop_opts.verbose ++;
+    gsl_vector_free(v);
+    gsl_vector_free(v2);
+}
+
 void test_transpose(){
     apop_data *t = apop_text_to_data( DATADIR "/" "test_data" , 0, 1);
     apop_data *tt = apop_data_transpose(t, .inplace='n');
@@ -930,6 +1498,139 @@ void test_unique_elements(){
     assert(!strcmp(".", dt->text[0][0]));
     assert(!strcmp("Hi,", dt->text[1][0]));
     assert(!strcmp("text", dt->text[5][0]));
+
+    apop_data *tc = apop_text_unique_counts(t, 0);
+    assert(tc->textsize[0] == 7);
+    assert(!strcmp(".", tc->text[0][0]) && tc->weights->data[0] == 2);
+    assert(!strcmp("there", tc->text[4][0]) && tc->weights->data[4] == 2);
+    assert(apop_sum(tc->weights) == 9);
+
+    //NaNs are all one element, at the end; -0 is 0.
+    double dn[] = {NAN, 2, -0., NAN, 0, 1, 2, NAN};
+    apop_data *counts = apop_vector_unique_counts(apop_array_to_vector(dn, 8));
+    assert(counts->vector->size == 4);
+    assert(gsl_vector_get(counts->vector, 0) == 0 && gsl_vector_get(counts->weights, 0) == 2);
+    assert(gsl_vector_get(counts->vector, 2) == 2 && gsl_vector_get(counts->weights, 2) == 2);
+    assert(isnan(gsl_vector_get(counts->vector, 3)) && gsl_vector_get(counts->weights, 3) == 3);
+
+    //high cardinality
+    size_t n = 200000;
+    gsl_vector *ids = gsl_vector_alloc(n);
+    for (size_t i=0; i< n; i++) gsl_vector_set(ids, i, (i*7919) % (n/2));
+    gsl_vector *uids = apop_vector_unique_elements(ids);
+    assert(uids->size == n/2);
+    for (size_t i=0; i< n/2; i++) assert(gsl_vector_get(uids, i) == i);
+    gsl_vector_free(ids); gsl_vector_free(uids);
+    apop_data_free(tc); apop_data_free(counts);
+}
+
+//The analytic scores, for two and three options, match the numerical gradient.
+void test_probit_and_logit_scores(gsl_rng *r){
+    for (int options=2; options <= 3; options++){
+        apop_data *d = apop_data_alloc(500, 3);
+        for (int i=0; i< 500; i++){
+            apop_data_set(d, i, 0, gsl_rng_uniform_int(r, options));
+            apop_data_set(d, i, 1, gsl_rng_uniform(r)*2 - 1);
+            apop_data_set(d, i, 2, gsl_ran_gaussian(r, 1));
+        }
+        apop_model *models[] = {apop_logit, apop_probit};
+        for (int k=0; k< 2; k++){
+            apop_data *dd = apop_data_copy(d);
+            apop_model *m = apop_model_copy(models[k]);
+            apop_prep(dd, m);
+            int tsize = m->parameters->matrix->size1*m->parameters->matrix->size2;
+            for (int j=0; j< tsize; j++)
+                m->parameters->matrix->data[j] = (gsl_rng_uniform(r)-.5)/2;
+            gsl_vector *analytic = gsl_vector_alloc(tsize);
+            apop_score(dd, analytic, m);
+            gsl_vector *numeric = apop_numerical_gradient(dd, m, 1e-5);
+            for (int j=0; j< tsize; j++)
+                Diff(gsl_vector_get(analytic, j), gsl_vector_get(numeric, j), 1e-4*(1+fabs(gsl_vector_get(analytic, j))));
+            gsl_vector_free(analytic); gsl_vector_free(numeric);
+            apop_model_free(m); apop_data_free(dd);
+        }
+        apop_data_free(d);
+    }
+}
+
+static apop_dual normal_dual_ll(apop_data *d, apop_dual const *params, apop_model *m){
+    apop_dual ll = apop_dual_const(0),
+              twovar = apop_dual_scale(apop_dual_mul(params[1], params[1]), 2),
+              norm = apop_dual_add(apop_dual_log(params[1]), apop_dual_const((M_LNPI+M_LN2)/2));
+    for (size_t i=0; i< d->matrix->size1; i++){
+        apop_dual dev = apop_dual_sub(apop_dual_const(gsl_matrix_get(d->matrix, i, 0)), params[0]);
+        ll = apop_dual_sub(ll, apop_dual_add(norm, apop_dual_div(apop_dual_mul(dev, dev), twovar)));
+    }
+    return ll;
+}
+
+static apop_dual poisson_dual_ll(apop_data *d, apop_dual const *params, apop_model *m){
+    apop_dual ll = apop_dual_const(0), lnlambda = apop_dual_log(params[0]);
+    for (size_t i=0; i< d->matrix->size1; i++){
+        double x = gsl_matrix_get(d->matrix, i, 0);
+        ll = apop_dual_add(ll, apop_dual_sub(apop_dual_scale(lnlambda, x), params[0]));
+        ll = apop_dual_sub(ll, apop_dual_lgamma(apop_dual_const(x+1)));
+    }
+    return ll;
+}
+
+static apop_dual logit_dual_ll(apop_data *d, apop_dual const *params, apop_model *m){
+    apop_dual ll = apop_dual_const(0);
+    for (size_t i=0; i< d->matrix->size1; i++){
+        apop_dual xb = apop_dual_add(apop_dual_scale(params[0], gsl_matrix_get(d->matrix, i, 0)),
+                                     apop_dual_scale(params[1], gsl_matrix_get(d->matrix, i, 1)));
+        ll = apop_dual_add(ll, apop_dual_sub(apop_dual_scale(xb, d->vector->data[i]),
+                                  apop_dual_log(apop_dual_add(apop_dual_const(1), apop_dual_exp(xb)))));
+    }
+    return ll;
+}
+
+static void compare_dual_score(apop_data *d, apop_model *m){
+    int ct = m->parameters->vector ? m->parameters->vector->size 
+                                   : m->parameters->matrix->size1*m->parameters->matrix->size2;
+    gsl_vector *analytic = gsl_vector_alloc(ct), *dual = gsl_vector_alloc(ct);
+    apop_score(d, analytic, m);
+    assert(!apop_dual_score(d, dual, m));
+    for (int j=0; j< ct; j++)
+        Diff(gsl_vector_get(analytic, j), gsl_vector_get(dual, j), 1e-8*(1+fabs(gsl_vector_get(analytic, j))));
+    gsl_vector_free(analytic); gsl_vector_free(dual);
+}
+
+//Dual-number gradients match the bundled analytic scores.
+void test_dual_scores(gsl_rng *r){
+    apop_dual_ll_vtable_add(normal_dual_ll, apop_normal);
+    apop_dual_ll_vtable_add(poisson_dual_ll, apop_poisson);
+    apop_dual_ll_vtable_add(logit_dual_ll, apop_logit);
+
+    apop_data *nd = apop_model_draws(apop_model_set_parameters(apop_normal, 1.5, 2), 1000);
+    compare_dual_score(nd, apop_model_set_parameters(apop_normal, 1.2, 2.5));
+
+    apop_data *pd = apop_model_draws(apop_model_set_parameters(apop_poisson, 3), 1000);
+    compare_dual_score(pd, apop_model_set_parameters(apop_poisson, 2.6));
+
+    apop_data *ld = apop_data_alloc(1000, 2);
+    for (int i=0; i< 1000; i++){
+        apop_data_set(ld, i, 0, gsl_rng_uniform(r) < 0.4);
+        apop_data_set(ld, i, 1, gsl_ran_gaussian(r, 1));
+    }
+    apop_model *logit = apop_model_copy(apop_logit);
+    apop_prep(ld, logit);
+    apop_data_set(logit->parameters, 0, 0, -0.3);
+    apop_data_set(logit->parameters, 1, 0, 0.2);
+    compare_dual_score(ld, logit);
+
+    //One-variable spot checks: f(x) = x^x and the Normal CDF.
+    apop_dual x = {.val=1.7, .dx=1};
+    Diff(apop_dual_pow(x, x).dx, pow(1.7, 1.7)*(log(1.7)+1), 1e-12);
+    Diff(apop_dual_lgamma(x).dx, gsl_sf_psi(1.7), 1e-12);
+    Diff(apop_dual_normal_cdf(x).dx, gsl_ran_gaussian_pdf(1.7, 1), 1e-12);
+    Diff(apop_dual_pow(apop_dual_const(-2), apop_dual_const(3)).val, -8, 1e-12);
+
+    apop_dual_ll_vtable_drop(apop_normal);
+    apop_dual_ll_vtable_drop(apop_poisson);
+    apop_dual_ll_vtable_drop(apop_logit);
+    apop_data_free(nd); apop_data_free(pd); apop_data_free(ld);
+    apop_model_free(logit);
 }
 
 void test_probit_and_logit(gsl_rng *r){
@@ -1099,6 +1800,344 @@ void test_arms(gsl_rng *r){
     apop_model_free(test_copying);
 }
 
+void test_arms_batch(gsl_rng *r){
+    int drawct = 2e4;
+    apop_model *single = apop_model_set_parameters(apop_normal, 1.1, 1.23);
+    single->draw = NULL;
+    apop_model *batched = apop_model_copy(single);
+    apop_data *one_at_a_time = apop_data_alloc(drawct);
+    apop_data *by_batch = apop_data_alloc(drawct);
+    for (int i=0; i< drawct; i++)
+        assert(!apop_arms_draw(one_at_a_time->vector->data+i, r, single));
+    assert(!apop_arms_draw_batch(by_batch->vector->data, drawct, r, batched));
+
+    apop_model *pmf1 = apop_estimate(apop_data_sort(one_at_a_time), apop_pmf);
+    apop_model *pmf2 = apop_estimate(apop_data_sort(by_batch), apop_pmf);
+    apop_data *ktest = apop_test_kolmogorov(pmf1, pmf2);
+    assert(apop_data_get(ktest, .rowname="p value, 2 tail") > .01);
+    apop_data_free(ktest);
+    ktest = apop_test_kolmogorov(pmf2, single);
+    assert(apop_data_get(ktest, .rowname="max distance") < .03);
+    apop_data_free(ktest);
+    apop_model_free(pmf1); apop_model_free(pmf2);
+    apop_data_free(one_at_a_time); apop_data_free(by_batch);
+    apop_model_free(single); apop_model_free(batched);
+}
+
+void test_threaded_derivatives(gsl_rng *r){
+    apop_model *g = apop_model_set_parameters(apop_gamma, 1.6, 2.3);
+    apop_data *d = apop_model_draws(g, 2000);
+    Apop_model_add_group(g, apop_mle, .threaded='n');
+    gsl_vector *serial_grad = apop_numerical_gradient(d, g);
+    apop_data *serial_hess = apop_model_hessian(d, g);
+    Apop_settings_set(g, apop_mle, threaded, 'y');
+    gsl_vector *threaded_grad = apop_numerical_gradient(d, g);
+    apop_data *threaded_hess = apop_model_hessian(d, g);
+    for (int i=0; i< 2; i++){
+        assert(serial_grad->data[i] == threaded_grad->data[i]);
+        for (int j=0; j< 2; j++)
+            assert(apop_data_get(serial_hess, i, j) == apop_data_get(threaded_hess, i, j));
+    }
+    assert(apop_data_get(g->parameters, 0, -1) == 1.6); //parameters are left as they were.
+    gsl_vector_free(serial_grad); gsl_vector_free(threaded_grad);
+    apop_data_free(serial_hess); apop_data_free(threaded_hess);
+    apop_data_free(d); apop_model_free(g);
+}
+
+static long double always_nan(apop_data *d, apop_model *m){ return GSL_NAN; }
+
+void test_multistart(gsl_rng *r){
+    apop_model *source = apop_model_set_parameters(apop_normal, 2.2, 1.3);
+    apop_data *data = apop_model_draws(source, 5000);
+    apop_model *estme = apop_model_copy(apop_normal);
+    Apop_model_add_group(estme, apop_mle, .method="NM simplex", .starts=6, .rng=r,
+                    .lower_bound=(double[]){-10, 0.1}, .upper_bound=(double[]){10, 10});
+    Apop_model_add_group(estme, apop_parts_wanted, .covariance='y', .info='y');
+    apop_prep(data, estme);
+    apop_maximum_likelihood(data, estme);
+    apop_model *straight_est = apop_estimate(data, apop_normal);
+    Diff(estme->parameters->vector->data[0], straight_est->parameters->vector->data[0], tol2);
+    Diff(estme->parameters->vector->data[1], straight_est->parameters->vector->data[1], tol2);
+
+    assert(apop_data_get(estme->info, .rowname="starts") == 6);
+    apop_data *optima = apop_data_get_page(estme->info, "<Optima>");
+    assert(optima && optima->matrix->size1 == 6);
+    assert(apop_data_get(optima, 0, 0) == apop_data_get(estme->info, .rowname="log likelihood"));
+    for (int i=1; i< 6; i++)
+        assert(apop_data_get(optima, i, 0) <= apop_data_get(optima, i-1, 0));
+    assert(apop_data_get(estme->info, .rowname="starts reaching the best optimum") >= 1);
+    //Covariance for the winner only, at the winning parameters.
+    apop_data *cov = apop_data_get_page(estme->parameters, "<Covariance>");
+    assert(cov);
+    Diff(apop_data_get(cov, 0, 0), gsl_pow_2(estme->parameters->vector->data[1])/5000, 3e-5);
+
+    //Every search fails: an error, not a garbage optimum.
+    apop_model *hopeless = apop_model_copy(&(apop_model){"Nowhere", .vsize=2, .dsize=1,
+                                                    .log_likelihood=always_nan});
+    Apop_model_add_group(hopeless, apop_mle, .method="NM simplex", .starts=3, .rng=r,
+                    .max_iterations=20);
+    apop_prep(data, hopeless);
+    apop_opts.verbose --;
+    apop_maximum_likelihood(data, hopeless);
+    apop_opts.verbose ++;
+    assert(hopeless->error == 'n');
+    assert(apop_data_get_page(hopeless->info, "<Optima>"));
+
+    apop_model_free(hopeless);
+    apop_model_free(straight_est); apop_model_free(estme);
+    apop_model_free(source); apop_data_free(data);
+}
+
+void test_lbfgs(){
+    apop_model *source = apop_model_set_parameters(apop_normal, 2.2, 1.3);
+    apop_data *data = apop_model_draws(source, 5000);
+    apop_model *straight_est = apop_estimate(data, apop_normal);
+
+    apop_model *estme = apop_model_copy(apop_normal);
+    Apop_model_add_group(estme, apop_mle, .method="L-BFGS", .tolerance=1e-6);
+    apop_prep(data, estme);
+    apop_maximum_likelihood(data, estme);
+    Diff(estme->parameters->vector->data[0], straight_est->parameters->vector->data[0], tol3);
+    Diff(estme->parameters->vector->data[1], straight_est->parameters->vector->data[1], tol3);
+    assert(apop_data_get(estme->info, .rowname="status") == 0);
+
+    //With the mean bounded away from the optimum, the search stops at the bound.
+    apop_model *bounded = apop_model_copy(apop_normal);
+    Apop_model_add_group(bounded, apop_mle, .method="L-BFGS", .tolerance=1e-6,
+            .lower_bound=(double[]){3, 0.1}, .upper_bound=(double[]){5, 10});
+    apop_prep(data, bounded);
+    apop_maximum_likelihood(data, bounded);
+    assert(bounded->parameters->vector->data[0] == 3);
+    assert(bounded->parameters->vector->data[1] > 0.1 && bounded->parameters->vector->data[1] < 10);
+
+    apop_model *hopeless = apop_model_copy(&(apop_model){"Nowhere", .vsize=2, .dsize=1,
+                                                    .log_likelihood=always_nan});
+    Apop_model_add_group(hopeless, apop_mle, .method="L-BFGS");
+    apop_prep(data, hopeless);
+    apop_opts.verbose --;
+    apop_maximum_likelihood(data, hopeless);
+    apop_opts.verbose ++;
+    assert(hopeless->error == 'n');
+    apop_model_free(hopeless);
+    apop_model_free(estme); apop_model_free(bounded); apop_model_free(straight_est);
+    apop_model_free(source); apop_data_free(data);
+}
+
+void test_sgd(){
+    apop_model *source = apop_model_set_parameters(apop_normal, 2.2, 1.3);
+    apop_data *data = apop_model_draws(source, 20000);
+    apop_model *straight_est = apop_estimate(data, apop_normal);
+
+    apop_model *estme = apop_model_copy(apop_normal);
+    Apop_model_add_group(estme, apop_mle, .method="SGD", .batch_size=200, 
+                .learning_decay=.01, .rng=apop_rng_alloc(3141));
+    apop_prep(data, estme);
+    apop_maximum_likelihood(data, estme);
+    Diff(estme->parameters->vector->data[0], straight_est->parameters->vector->data[0], 5e-2);
+    Diff(estme->parameters->vector->data[1], straight_est->parameters->vector->data[1], 5e-2);
+    gsl_rng_free(Apop_settings_get(estme, apop_mle, rng));
+
+    //SGD needs a log likelihood; with only p, fail, but report a status like the other methods.
+    apop_model *p_only = apop_model_copy(&(apop_model){"p only", .vsize=2, .dsize=1, .p=always_nan});
+    Apop_model_add_group(p_only, apop_mle, .method="SGD");
+    apop_prep(data, p_only);
+    apop_opts.verbose --;
+    apop_maximum_likelihood(data, p_only);
+    apop_opts.verbose ++;
+    assert(p_only->error == 'm');
+    assert(apop_data_get(p_only->info, .rowname="status") == -1);
+    apop_model_free(p_only);
+    apop_model_free(estme); apop_model_free(straight_est);
+    apop_model_free(source); apop_data_free(data);
+}
+
+static int ll_calls;
+static long double counted_normal_ll(apop_data *d, apop_model *m){
+    ll_calls++;
+    return apop_normal->log_likelihood(d, m);
+}
+
+/* With a path recorded, the gradient step re-evaluates the log likelihood at the point
+   just evaluated, so the cache gets hits; the search itself is unchanged. Declaring the
+   log likelihood stochastic turns the cache off. */
+void test_ll_cache(){
+    apop_data *data = apop_model_draws(apop_model_set_parameters(apop_normal, 0.8, 1.9), 500);
+    apop_model *counted = apop_model_copy(apop_normal);
+    counted->log_likelihood = counted_normal_ll;
+    int calls[3];
+    double params[3][2];
+    for (int cache=0; cache< 3; cache++){
+        apop_data *path = NULL;
+        apop_model *m = apop_model_copy(counted);
+        Apop_model_add_group(m, apop_mle, .method="PR cg", .ll_cache= cache ? 10 : 0, .path=&path,
+                                .stochastic= cache==2 ? 'y' : 'n');
+        apop_prep(data, m);
+        ll_calls = 0;
+        apop_maximum_likelihood(data, m);
+        calls[cache] = ll_calls;
+        params[cache][0] = m->parameters->vector->data[0];
+        params[cache][1] = m->parameters->vector->data[1];
+        apop_opts.verbose --;
+        double hits = apop_data_get(m->info, .rowname="log likelihood cache hits"),
+               lookups = apop_data_get(m->info, .rowname="log likelihood cache lookups");
+        apop_opts.verbose ++;
+        if (cache==1) assert(hits > 0 && lookups >= hits);
+        else          assert(gsl_isnan(hits) && gsl_isnan(lookups)); //no cache, no report.
+        apop_model_free(m); apop_data_free(path);
+    }
+    assert(calls[1] < calls[0]);
+    assert(calls[2] == calls[0]);
+    assert(params[0][0] == params[1][0] && params[0][1] == params[1][1]);
+    apop_model_free(counted); apop_data_free(data);
+}
+
+static void count_trace_rows(apop_data *row, void *ct){
+    assert(row->matrix->size1 == 1);
+    assert(!strcmp(row->names->col[1], "log likelihood"));
+    (*(int*)ct)++;
+}
+
+void test_mle_trace(){
+    apop_data *data = apop_model_draws(apop_model_set_parameters(apop_normal, 0.8, 1.9), 500);
+    char *methods[] = {"L-BFGS", "PR cg", "NM simplex"};
+    for (int k=0; k< 3; k++){
+        int callbacks = 0;
+        apop_model *m = apop_model_copy(apop_normal);
+        Apop_model_add_group(m, apop_mle, .method=methods[k], .trace='y',
+                                .trace_fn=count_trace_rows, .trace_param=&callbacks);
+        apop_prep(data, m);
+        apop_maximum_likelihood(data, m);
+        apop_data *trace = apop_data_get_page(m->info, "<Trace>");
+        assert(trace);
+        int rows = trace->matrix->size1;
+        assert(rows > 0 && rows == callbacks);
+        assert(trace->matrix->size2 == 9);
+        assert(gsl_isnan(apop_data_get(trace, 0, 3))); //no step before the first.
+        for (int i=1; i< rows; i++){
+            assert(apop_data_get(trace, i, 0) > apop_data_get(trace, i-1, 0));
+            assert(apop_data_get(trace, i, 4) >= apop_data_get(trace, i-1, 4));
+            assert(apop_data_get(trace, i, 6) >= apop_data_get(trace, i-1, 6));
+        }
+        if (k < 2) assert(!gsl_isnan(apop_data_get(trace, rows-1, 2)));
+        else assert(gsl_isnan(apop_data_get(trace, rows-1, 2)));
+        apop_model_free(m);
+    }
+
+    //Every evaluation is counted, including those for numerical gradients and the Hessian.
+    apop_model *m = apop_model_copy(apop_normal);
+    m->log_likelihood = counted_normal_ll;
+    Apop_model_add_group(m, apop_mle, .method="PR cg", .trace='y');
+    Apop_model_add_group(m, apop_parts_wanted, .covariance='y');
+    apop_prep(data, m);
+    ll_calls = 0;
+    apop_maximum_likelihood(data, m);
+    assert(apop_data_get(m->info, .rowname="log likelihood evaluations") == ll_calls);
+    apop_data *trace = apop_data_get_page(m->info, "<Trace>");
+    assert(apop_data_get(trace, trace->matrix->size1-1, 4) <= ll_calls);
+    assert(apop_data_get(m->info, .rowname="gradient evaluations") 
+                    >= apop_data_get(trace, trace->matrix->size1-1, 5));
+    apop_model_free(m);
+
+    //Done before the first iteration: no trace rows.
+    m = apop_model_copy(apop_normal);
+    Apop_model_add_group(m, apop_mle, .method="L-BFGS", .trace='y', .tolerance=1e10);
+    apop_prep(data, m);
+    apop_maximum_likelihood(data, m);
+    trace = apop_data_get_page(m->info, "<Trace>");
+    assert(!trace || !trace->matrix);
+    apop_model_free(m);
+    apop_data_free(data);
+}
+
+void test_parallel_tempering(){
+    apop_data *data = apop_model_draws(apop_model_set_parameters(apop_normal, 1.5, 2), 200);
+    apop_model *straight_est = apop_estimate(data, apop_normal);
+    double first_run[2];
+    //Run twice serially, then once with the walks on threads; all three must match exactly.
+    for (int run=0; run< 3; run++){
+        apop_model *m = apop_model_copy(apop_normal);
+        gsl_rng *r = apop_rng_alloc(2718);
+        Apop_model_add_group(m, apop_mle, .method="Parallel tempering", .replicas=6,
+                .t_initial=10, .t_min=.01, .mu_t=1.01, .rng=r, .threaded= run==2 ? 'y' : 'n');
+        apop_prep(data, m);
+        apop_maximum_likelihood(data, m);
+        Diff(m->parameters->vector->data[0], straight_est->parameters->vector->data[0], 0.1);
+        Diff(m->parameters->vector->data[1], straight_est->parameters->vector->data[1], 0.1);
+        double swap_rate = apop_data_get(m->info, .rowname="swap acceptance rate");
+        assert(swap_rate > 0 && swap_rate <= 1);
+        //Same seed, same answer, with or without threads.
+        if (!run) memcpy(first_run, m->parameters->vector->data, 2*sizeof(double));
+        else assert(!memcmp(first_run, m->parameters->vector->data, 2*sizeof(double)));
+        gsl_rng_free(r);
+        apop_model_free(m);
+    }
+    apop_model_free(straight_est); apop_data_free(data);
+}
+
+//The MLE evaluates vector-only parameters in place; the model's own storage must survive it.
+void test_aliased_parameters(){
+    apop_data *data = apop_model_draws(apop_model_set_parameters(apop_normal, -1.1, 0.7), 2000);
+    apop_model *straight_est = apop_estimate(data, apop_normal);
+    char *methods[] = {"NM simplex", "PR cg", "Newton"};
+    for (int k=0; k< 3; k++){
+        apop_model *estme = apop_model_copy(apop_normal);
+        Apop_model_add_group(estme, apop_mle, .method=methods[k], .tolerance=1e-6);
+        apop_prep(data, estme);
+        double *storage = estme->parameters->vector->data;
+        apop_maximum_likelihood(data, estme);
+        assert(estme->parameters->vector->data == storage);
+        Diff(estme->parameters->vector->data[0], straight_est->parameters->vector->data[0], 1e-2);
+        Diff(estme->parameters->vector->data[1], straight_est->parameters->vector->data[1], 1e-2);
+        apop_model_free(estme);
+    }
+    apop_model_free(straight_est); apop_data_free(data);
+}
+
+void test_mcmc_thin_and_stream(gsl_rng *r){
+    apop_data *d = apop_model_draws(apop_model_set_parameters(apop_normal, 1, 2), 500);
+    apop_model *n = apop_model_copy(apop_normal);
+    Apop_settings_add_group(n, apop_mcmc, .periods=1000, .burnin=.1, .thin=3,
+                    .output_name="mcmc_draws", .batch_size=100, .keep_draws=50);
+    apop_model *out = apop_model_metropolis(d, r, n);
+    assert(out->data->matrix->size1 == 50);
+    assert(apop_data_get(out->info, .rowname="draws recorded") == 300);
+    apop_data *streamed = apop_text_to_data("mcmc_draws", 0, 0);
+    assert(streamed->matrix->size1 == 300);
+    //the in-memory draws are the tail of the streamed chain.
+    for (int i=0; i< 50; i++)
+        for (int j=0; j< 2; j++)
+            Diff(apop_data_get(out->data, i, j), apop_data_get(streamed, 250+i, j), 1e-3);
+    apop_data *moments = apop_data_get_page(out->info, "<Chain moments>");
+    Diff(apop_data_get(moments, .rowname="mean", .col=0), apop_vector_mean(Apop_cv(streamed, 0)), 1e-3);
+    apop_data_free(streamed);
+    apop_model_free(out);
+
+    //Streaming to the database inside the caller's own transaction.
+    apop_model *n2 = apop_model_copy(apop_normal);
+    Apop_settings_add_group(n2, apop_mcmc, .periods=1000, .burnin=.1, .thin=3,
+                    .output_name="mcmc_tab", .output_type='d', .batch_size=100);
+    apop_table_exists("mcmc_tab", 'd');
+    apop_query("begin;");
+    out = apop_model_metropolis(d, r, n2);
+    assert(!apop_query("commit;")); //fails if the MCMC already closed our transaction
+    assert(apop_query_to_float("select count(*) from mcmc_tab") == 300);
+    apop_model_free(out);
+    apop_model_free(n2);
+
+    //No draws survive the burn-in: an error, not a crash.
+    apop_model *n3 = apop_model_copy(apop_normal);
+    Apop_settings_add_group(n3, apop_mcmc, .periods=100, .burnin=1);
+    apop_opts.verbose --;
+    out = apop_model_metropolis(d, r, n3);
+    apop_opts.verbose ++;
+    assert(out->error == 'n');
+    assert(apop_data_get(out->info, .rowname="draws recorded") == 0);
+    apop_model_free(out);
+    apop_model_free(n3);
+    apop_model_free(n);
+    apop_data_free(d);
+}
+
 void test_pmf_compress(gsl_rng *r){
     apop_data *d = apop_data_alloc();
     apop_text_alloc(d, 9, 1);
@@ -1232,13 +2271,19 @@ int main(int argc, char **argv){
     do_test("test listwise delete", test_listwise_delete());
     do_test("rownames", test_rownames());
     do_test("apop_dot", test_dot());
+    do_test("apop_dot_into", test_dot_into(r));
+    do_test("randomized PCA", test_randomized_pca(r));
     do_test("apop_jackknife", test_jackknife(r));
     do_test("test multivariate_normal", test_multivariate_normal());
+    do_test("multivariate normal cached factorization", test_mvn_cached_factor());
     do_test("log and exponent", log_and_exp(r));
     do_test("split and stack test", test_split_and_stack(r));
     do_test("test probit and logit", test_probit_and_logit(r));
+    do_test("probit and logit scores", test_probit_and_logit_scores(r));
+    do_test("dual-number scores", test_dual_scores(r));
     do_test("test probit and logit again", test_probit_and_logit(r));
     do_test("test data compressing", test_pmf_compress(r));
+    do_test("parallel MCMC draws", test_parallel_mcmc_draws());
     do_test("weighted regression", test_weighted_regression(d,e));
     do_test("offset OLS", test_ols_offset(r));
     do_test("default RNG", test_default_rng(r));
@@ -1246,17 +2291,33 @@ int main(int argc, char **argv){
     do_test("test PMF", test_pmf());
     do_test("apop_pack/unpack test", apop_pack_test(r));
     do_test("test adaptive rejection sampling", test_arms(r));
+    do_test("ARMS batch draws", test_arms_batch(r));
+    do_test("threaded numerical derivatives", test_threaded_derivatives(r));
+    do_test("multi-start MLE", test_multistart(r));
+    do_test("L-BFGS MLE", test_lbfgs());
+    do_test("in-place parameter evaluation", test_aliased_parameters());
+    do_test("minibatch SGD MLE", test_sgd());
+    do_test("log likelihood cache", test_ll_cache());
+    do_test("MLE trace", test_mle_trace());
+    do_test("parallel tempering", test_parallel_tempering());
+    do_test("MCMC thinning and streaming", test_mcmc_thin_and_stream(r));
     //do_test("test fix params", test_model_fix_parameters(r));
     do_test("positive definiteness", test_posdef(r));
     do_test("test binomial estimations", test_binomial(r));
     do_test("dummies and factors", dummies_and_factors());
     do_test("test vector/matrix realloc", test_resize());
     do_test("test_vector_moving_average", test_vector_moving_average());
+    do_test("rolling-window statistics", test_vector_rolling(r));
     do_test("apop_estimate->dependent test", test_predicted_and_residual(e));
     do_test("OLS test", test_OLS(r));
     do_test("database skew, kurtosis, normalization", test_skew_and_kurt(r));
     do_test("test_percentiles", test_percentiles());
     do_test("weighted moments", test_weigted_moments());
+    do_test("ill-conditioned moments", test_ill_conditioned_moments());
+    do_test("covariance and correlation matrices", test_covariance_matrix(r));
+    do_test("mergeable accumulators", test_accumulators(r));
+    do_test("t-digest quantile sketch", test_tdigest(r));
+    do_test("distance matrices", test_distance_matrix(r));
     do_test("multivariate gamma", test_mvn_gamma());
     do_test("Inversion", test_inversion(r));
     do_test("apop_matrix_summarize", test_summarize());